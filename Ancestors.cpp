@@ -70,7 +70,10 @@ int main(int argc, char **argv) {
     return EXIT_FAILURE;
   }
 
-  PackedGraph g(argv[1]);
+  PackedGraphOptions mapping;
+  mapping.readOnly=true;
+  mapping.access=ACCESS_RANDOM;
+  const PackedGraph g(argv[1],mapping);
 
   for(auto i = 2; i<argc; ++i) {
     auto node = g.getNodeWithLabel(argv[i]);
@@ -23,40 +23,74 @@
  */
 
 #include <iostream>
-#include <fstream>
+#include <sstream>
+#include <deque>
+#include <limits>
 #include <cstdlib>
 
-#include "MutableGraph.h"
+#include "EdgeList.h"
+#include "GraphBuilder.h"
 
 using namespace std;
 using namespace lsg;
 
 int main(int argc, char **argv)
 {
-  if(argc!=4) {
-    cerr << "Usage : " << argv[0] << " edge_list labels graph" << endl;
+  if(argc!=4 && argc!=5) {
+    cerr << "Usage : " << argv[0] << " edge_list labels graph [memory_MB]"
+         << endl;
     return EXIT_FAILURE;
   }
 
-  ifstream edge_list(argv[1]);
+  size_t memory=GraphBuilder::DEFAULT_MEMORY;
+  if(argc==5) {
+    stringstream ss(argv[4]);
+    unsigned long megabytes;
+    if(!(ss >> megabytes) || !ss.eof() || argv[4][0]=='-' ||
+       megabytes<1 || megabytes>(numeric_limits<size_t>::max()>>20)) {
+      cerr << "Invalid memory size " << argv[4] << endl;
+      return EXIT_FAILURE;
+    }
+    memory=static_cast<size_t>(megabytes)<<20;
+  }
+
+  EdgeList edge_list(argv[1]);
+  if(!edge_list.isOk()) {
+    cerr << "Cannot read " << argv[1] << endl;
+    return EXIT_FAILURE;
+  }
+
+  const node_t size=edge_list.getNbNodes();
+  GraphBuilder builder(argv[3],size,memory);
 
   cerr << "Loading edge list..." << endl;
-  MutableGraph g(edge_list);
+  {
+    const unsigned nbThreads=getNbThreads();
+    deque<GraphBuilder::Inserter> inserters;
+    for(unsigned t=0;t<nbThreads;++t)
+      inserters.emplace_back(builder,nbThreads);
 
-  cerr << "Adding labels..." << endl;
-  ifstream labels(argv[2]);
-  node_t size=g.getNbNodes();
-  for(node_t i=0;i<size && labels;++i) {
-    string s;
-    getline(labels,s);
-    while(s.size() && (s[s.size()-1] == '\r' || s[s.size()-1] == '\n')) {
-      s = s.substr( 0, s.size() - 1 );
+    if(!edge_list.parse([&inserters](unsigned t,node_t i,node_t j,value_t v) {
+          inserters[t].add(i,j,v);
+        },nbThreads)) {
+      cerr << "Syntax error in " << argv[1] << endl;
+      builder.abort();
+      return EXIT_FAILURE;
     }
-    g.setLabel(i,s);
+  }
+
+  cerr << "Adding labels..." << endl;
+  LabelFile labels(argv[2]);
+  if(labels.isOk()) {
+    for(node_t i=0;i<size && i<labels.getNbLabels();++i)
+      builder.addLabel(labels.getLabel(i));
   }
 
   cerr << "Storing graph..." << endl;
-  g.store(argv[3]);
+  if(!builder.close()) {
+    cerr << "Cannot build " << argv[3] << endl;
+    return EXIT_FAILURE;
+  }
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "PackedGraph.h"
+#include "GraphProduct.h"
+
+using namespace std;
+using namespace lsg;
+
+int main(int argc, char **argv)
+{
+  if(argc<4 || argc>5 ||
+     (string(argv[3])!="backward" && string(argv[3])!="forward")) {
+    cerr << "Usage : " << argv[0]
+         << " graph graph_out backward|forward [k]" << endl;
+    return EXIT_FAILURE;
+  }
+
+  cerr << "Loading graph..." << endl;
+  PackedGraphOptions mapping;
+  mapping.readOnly=true;
+  const PackedGraph g(argv[1],mapping);
+
+  if(!g.isOk()) {
+    cerr << "Cannot load " << argv[1] << endl;
+    return EXIT_FAILURE;
+  }
+
+  // Backward: number of nodes pointing to both i and j (a^T*a); forward:
+  // number of nodes both i and j point to (a*a^T)
+  GraphProductOptions options;
+  options.pattern=true;
+  options.diagonal=false;
+  if(string(argv[3])=="backward")
+    options.transposeLeft=true;
+  else
+    options.transposeRight=true;
+  if(argc==5)
+    options.topK=atoi(argv[4]);
+
+  cerr << "Computing co-citations..." << endl;
+  if(!storeProduct(g,g,argv[2],options)) {
+    cerr << "Cannot build " << argv[2] << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -25,28 +25,126 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string>
 
 #include "Vector.h"
+#include "MappedVector.h"
 #include "PackedGraph.h"
 #include "MarkovChains.h"
 
 using namespace std;
 using namespace lsg;
 
+bool readSolver(const string &name,MeasureSolver &solver)
+{
+  if(name=="power")
+    solver=SOLVER_POWER;
+  else if(name=="quadratic")
+    solver=SOLVER_QUADRATIC;
+  else if(name=="aitken")
+    solver=SOLVER_AITKEN;
+  else if(name=="gmres")
+    solver=SOLVER_GMRES;
+  else if(name=="bicgstab")
+    solver=SOLVER_BICGSTAB;
+  else
+    return false;
+  return true;
+}
+
 int main(int argc, char **argv)
 {
-  if(argc!=4&&argc!=5) {
-    cerr << "Usage : " << argv[0] << " graph niter measure" << endl;
-    cerr << "   or : " << argv[0] << " graph niter measure startmeasure" << endl;
+  const char *program=argv[0];
+  InvariantMeasureOptions options;
+  options.verbose=true;
+
+  // Explicit -solver or -maxiter options, and -iterations n, which
+  // replaces both and the tolerance argument
+  bool solverOptions=false;
+  unsigned iterations=0;
+
+  while(argc>=3 && argv[1][0]=='-') {
+    const string option=argv[1];
+    if(option=="-kernel") {
+      if(!parseKernel(argv[2],options.kernel)) {
+        cerr << "Unknown kernel " << argv[2] << endl;
+        return EXIT_FAILURE;
+      }
+    } else if(option=="-solver") {
+      if(!readSolver(argv[2],options.solver)) {
+        cerr << "Unknown solver " << argv[2] << endl;
+        return EXIT_FAILURE;
+      }
+      solverOptions=true;
+    } else if(option=="-maxiter") {
+      std::stringstream ss(argv[2]);
+      ss >> options.maxIterations;
+      solverOptions=true;
+    } else if(option=="-iterations") {
+      std::stringstream ss(argv[2]);
+      if(!(ss >> iterations) || !iterations) {
+        cerr << "Invalid number of iterations " << argv[2] << endl;
+        return EXIT_FAILURE;
+      }
+    } else
+      break;
+    argc-=2;
+    argv+=2;
+  }
+
+  // Without -iterations, the tolerance follows the graph
+  const int nbFiles=iterations?argc-1:argc-2;
+  if(nbFiles!=2&&nbFiles!=3) {
+    cerr << "Usage : " << program << " [options] graph tolerance measure [startmeasure]" << endl;
+    cerr << "   or : " << program << " -iterations n [-kernel k] graph measure [startmeasure]" << endl;
+    cerr << "Options: -kernel push|pull|blocked" << endl;
+    cerr << "         -solver power|quadratic|aitken|gmres|bicgstab (bicgstab)" << endl;
+    cerr << "         -maxiter n (" << options.maxIterations << ")" << endl;
+    cerr << "-iterations n runs n power iterations; so does a tolerance of n>=1," << endl;
+    cerr << "as formerly, without -solver and -maxiter." << endl;
     return EXIT_FAILURE;
   }
 
-  cerr << "Loading graph..." << endl;
-  PackedGraph g(argv[1]);
+  const char *graphFile=argv[1];
+  const char *measureFile=argv[argc-nbFiles+1];
+  const char *startFile=nbFiles==3?argv[argc-1]:0;
+
+  double tolerance=0.;
+  if(!iterations) {
+    std::stringstream ss(argv[2]);
+    if(!(ss >> tolerance) || tolerance<=0.) {
+      cerr << "Invalid tolerance " << argv[2] << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Former usage, with a fixed number of iterations
+  if(tolerance>=1.) {
+    if(solverOptions) {
+      cerr << "A number of iterations (" << tolerance << ") cannot be"
+           << " combined with -solver or -maxiter" << endl;
+      return EXIT_FAILURE;
+    }
+    iterations=static_cast<unsigned>(tolerance);
+  }
 
-  std::stringstream ss(argv[2]);
-  unsigned int niter;
-  ss >> niter;
+  if(iterations) {
+    if(solverOptions) {
+      cerr << "-iterations cannot be combined with -solver or -maxiter"
+           << endl;
+      return EXIT_FAILURE;
+    }
+    options.solver=SOLVER_POWER;
+    options.maxIterations=iterations;
+    options.tolerance=0.;
+  } else
+    options.tolerance=tolerance;
+
+  cerr << "Loading graph..." << endl;
+  PackedGraphOptions mapping;
+  mapping.readOnly=true;
+  mapping.access=ACCESS_SEQUENTIAL;
+  const PackedGraph g(graphFile,mapping);
 
   cerr << "Computing invariant measure..." << endl;
 
@@ -54,17 +152,36 @@ int main(int argc, char **argv)
 
   RowVector v(size);
 
-  if(argc==4)for(node_t i=0;i<size;++i)
+  if(!startFile)for(node_t i=0;i<size;++i)
     v[i]=1./size;
-	else if(argc==5){
-		v=RowVector(argv[4]);
+	else {
+		MappedVector start(startFile);
+		if(!start.isOk() || start.size()!=size) {
+			cerr << "Impossible to load the measure " << startFile << endl;
+			return EXIT_FAILURE;
+		}
+		for(node_t i=0;i<size;++i)
+			v[i]=start[i];
 	}
 
-//  anotherInvariantMeasure(g,v,niter,true);
-	InvariantMeasure(g,v,niter,true);
-  
+  const InvariantMeasureReport report=InvariantMeasure(g,v,options);
+  cerr << report.iterations << " iterations, " << report.products
+       << " products";
+  if(!report.residuals.empty())
+    cerr << ", residual " << report.residuals.back();
+  cerr << endl;
+  if(options.tolerance && !report.converged)
+    cerr << "Tolerance not reached" << endl;
+
   cerr << "Storing measure..." << endl;
-	v.store(argv[3]);
+  WritableMappedVector measure(measureFile,size);
+  if(!measure.isOk())
+    return EXIT_FAILURE;
+  for(node_t i=0;i<size;++i)
+    measure[i]=v[i];
+
+  if(!measure.close())
+    return EXIT_FAILURE;
 
-  return EXIT_SUCCESS;
+  return !options.tolerance || report.converged?EXIT_SUCCESS:EXIT_FAILURE;
 }
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <string>
+
+#include "PackedGraph.h"
+
+using namespace std;
+using namespace lsg;
+
+int main(int argc, char **argv)
+{
+  if(argc!=4 ||
+     (string(argv[3])!="compressed" && string(argv[3])!="csr")) {
+    cerr << "Usage : " << argv[0] << " graph new_graph csr|compressed"
+         << endl;
+    return EXIT_FAILURE;
+  }
+
+  cerr << "Loading graph..." << endl;
+  PackedGraphOptions mapping;
+  mapping.readOnly=true;
+  mapping.access=ACCESS_SEQUENTIAL;
+  const PackedGraph g(argv[1],mapping);
+
+  if(!g.isOk()) {
+    cerr << "Cannot load " << argv[1] << endl;
+    return EXIT_FAILURE;
+  }
+
+  cerr << "Converting graph..." << endl;
+  const string format=argv[3];
+  const bool ok=
+    format=="compressed"?g.storeCompressed(argv[2]):g.store(argv[2]);
+
+  return ok?EXIT_SUCCESS:EXIT_FAILURE;
+}
@@ -43,7 +43,9 @@ int main(int argc, char **argv)
 
   cerr << "Loading graph..." << endl;
 
-  PackedGraph g(argv[1]);
+  PackedGraphOptions mapping;
+  mapping.readOnly=true;
+  const PackedGraph g(argv[1],mapping);
 
   if(!g.isOk()) {
     cerr << "Impossible to load graph..." << endl;
@@ -59,7 +61,7 @@ int main(int argc, char **argv)
      * afterwards */
 
     std::vector<node_t> comp;
-    stronglyConnectedComponents(g,comp);
+    parallelStronglyConnectedComponents(g,comp);
 
     node_t nb_components=*max_element(comp.begin(),comp.end());
     cerr << "  " << nb_components
@@ -24,10 +24,11 @@
 
 #include <iostream>
 #include <fstream>
+#include <cmath>
 
 #include "PackedGraph.h"
 #include "MutableGraph.h"
-#include "Vector.h"
+#include "MappedVector.h"
 #include "MarkovChains.h"
 #include "Tools.h"
 
@@ -42,13 +43,20 @@ int main(int argc, char **argv)
   }
 
   cerr << "Copying graph..." << endl;
-  copyFile(argv[1],argv[2]);
+  if(!copyGraph(argv[1],argv[2])) {
+    cerr << "Impossible to copy the graph" << endl;
+    return EXIT_FAILURE;
+  }
   
 	cerr << "Loading graph..." << endl;
   PackedGraph gidf(argv[2]);
 
 	cerr << "Loading measure..." << endl;
-	RowVector v(argv[3]);
+	MappedVector v(argv[3]);
+  if(!v.isOk()) {
+    cerr << "Impossible to load the measure " << argv[3] << endl;
+    return EXIT_FAILURE;
+  }
 
   cerr << "Computing idf random walk..." << endl;
   for(node_t i=0;i<gidf.getNbNodes();i++){
@@ -40,7 +40,10 @@ int main(int argc, char **argv)
   }
 
   cerr << "Copying graph..." << endl;
-  copyFile(argv[1],argv[2]);
+  if(!copyGraph(argv[1],argv[2])) {
+    cerr << "Impossible to copy the graph" << endl;
+    return EXIT_FAILURE;
+  }
 
   cerr << "Loading graph..." << endl;
   PackedGraph g(argv[2]);
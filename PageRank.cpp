@@ -26,10 +26,12 @@
 #include <iomanip>
 #include <fstream>
 #include <set>
+#include <string>
 #include <utility>
 
 #include "PackedGraph.h"
 #include "Vector.h"
+#include "MarkovChains.h"
 
 using namespace std;
 using namespace lsg;
@@ -45,44 +47,43 @@ struct Comparator {
 
 int main(int argc, char **argv)
 {
+  const char *program=argv[0];
+  PageRankOptions options;
+
+  // With a kernel, power iterations replace Gauss-Seidel sweeps
+  if(argc==5 && string(argv[1])=="-kernel") {
+    if(!parseKernel(argv[2],options.kernel)) {
+      cerr << "Unknown kernel " << argv[2] << endl;
+      return EXIT_FAILURE;
+    }
+    options.powerIterations=true;
+    argc-=2;
+    argv+=2;
+  }
+
   if(argc!=3) {
-    cerr << "Usage: " << argv[0] << " graph out";
+    cerr << "Usage: " << program << " [-kernel push|pull|blocked] graph out"
+         << endl;
     return EXIT_FAILURE;
   }
 
   cerr << "Loading graph..." << endl;
-  PackedGraph g(argv[1]);
+  PackedGraphOptions mapping;
+  mapping.readOnly=true;
+  mapping.access=ACCESS_SEQUENTIAL;
+  const PackedGraph g(argv[1],mapping);
 
   node_t size=g.getNbNodes();
 
-  RowVector uniform(size);
-
-  for(node_t i=0;i<size;++i)
-    uniform[i]=1./size;
-
-  RowVector v=uniform,w=v;
-
-  RowVector uniform2=(1.-damping_factor)*uniform;
-
-  {double difference;
-  unsigned i=0;
-  do {
-    cerr << "Itération " << i+1 << endl;
-
-    w=v;
-    v=damping_factor*v*g+uniform2;
+  RowVector v;
 
-    cerr << "Somme des éléments de v : " << v.sum() << endl;
-    cerr << "Norme différence : " << abs(w-v).sum() << endl;
-    cerr << "Max différence : " << abs(w-v).max() << endl;
-    cerr << "Max : " << v.max() << endl;
-    cerr << "Min : " << v.min() << endl;
+  options.damping=damping_factor;
+  options.threshold=threshold;
+  options.verbose=true;
 
-    difference=(abs(w-v)/v).max();
-    cerr << "Différence relative : " << (abs(w-v)/v).max() << endl;
-    cerr << endl;
-    ++i;
-  } while(difference>=threshold);}
+  cerr << "Computing PageRank..." << endl;
+  unsigned nbIterations=PageRank(g,v,options);
+  cerr << nbIterations << " iterations" << endl;
 
   set<pair<node_t,double>,Comparator> s;
   for(node_t i=0;i<size;++i)
@@ -27,16 +27,35 @@
 #include <fstream>
 #include <cstdio>
 #include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
 #include<set>
 #include<map>
 
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
 #include "PackedGraph.h"
 #include "ConnectedComponents.h"
 #include "SparseArray.h"
 #include "MarkovChains.h"
 #include "Vector.h"
+#include "MappedVector.h"
 #include "NodeArray.h"
 #include "TempFile.h"
+#include "Tools.h"
+#include "Similarity.h"
+#include "GraphBuilder.h"
 
 using namespace std;
 using namespace lsg;
@@ -68,6 +87,54 @@ bool IsLinked(const Graph&g,node_t source,node_t dest)
  return g(source,dest)>0.;
 }
 
+// Where methods write: lines to a stream, and their final ranking of
+// related nodes (with a method name, see PrintNamesOfBest) to the
+// evaluation file, unless it is collected in ranking (see -index).
+// Unless verbose, progress messages (log), intermediate steps and the
+// evaluation file are dropped, so that only final results remain
+class Output {
+    ostream null;
+
+  public:
+    Output(ostream &s,bool verbose=true) :
+      null(0), stream(s), log(verbose?cerr:null), steps(verbose?s:null),
+      evaluation(verbose), graph(0), ranking(0), nbRanked(0) {}
+    // Final rankings are stored as nodes of g, at most nb of them
+    Output(ostream &s,const Graph &g,vector<pair<node_t,value_t> > &r,
+           node_t nb) :
+      null(0), stream(s), log(null), steps(null), evaluation(false),
+      graph(&g), ranking(&r), nbRanked(nb) {}
+
+    template<class T> Output &operator<<(const T &x)
+      { stream<<x; return *this; }
+    Output &operator<<(ostream &(*f)(ostream &))
+      { stream<<f; return *this; }
+
+    ostream &stream;
+    ostream &log;
+    ostream &steps;
+    bool evaluation;
+    const Graph *graph;
+    vector<pair<node_t,value_t> > *ranking;
+    node_t nbRanked;
+};
+
+// Scratch vectors of the current thread, reused from one query to the
+// next so that short walks do not cost the allocation of whole vectors
+FrontierVector &scratch(unsigned slot,node_t size)
+{
+  thread_local FrontierVector vectors[5];
+  FrontierVector &v=vectors[slot];
+  if(v.size()!=size)
+    v=FrontierVector(size);
+  else
+    v.clear();
+  return v;
+}
+
+// Serializes appends of concurrent queries (see -daemon)
+mutex evaluationMutex;
+
 template<class T>
 void addResultsToFileForSQLImport(const string &filename,
                                   const string &method,
@@ -77,31 +144,67 @@ void addResultsToFileForSQLImport(const string &filename,
                                   unsigned nb);
 
 template<class T>
-void PrintNamesOfBest(const Graph &g,const T& v, node_t nbest,const std::string &method, node_t base_article)
+void getEntries(const T& v,vector<pair<node_t,value_t> > &s)
 {
-  vector<pair<node_t,value_t> > s(v.size());
+  s.resize(v.size());
   for(node_t i=0;i<v.size();++i){
     s[i]=make_pair(i,v[i]);
   }
+}
+
+void getEntries(const NodeArray& v,vector<pair<node_t,value_t> > &s)
+{
+  s.clear();
+  for(SparseArray::const_iterator it=v.begin(),itend=v.end();it!=itend;++it)
+    s.push_back(make_pair(it.index(),*it));
+}
+
+void getEntries(const FrontierVector& v,vector<pair<node_t,value_t> > &s)
+{
+  s.clear();
+  v.forEach([&](node_t i,double x){s.push_back(make_pair(i,x));});
+}
+
+template<class T>
+void PrintNamesOfBest(Output &out,const Graph &g,const T& v, node_t nbest,const std::string &method, node_t base_article)
+{
+  vector<pair<node_t,value_t> > s;
+  getEntries(v,s);
 
-  partial_sort(s.begin(),s.begin()+nbest,s.end(),Comparator());
+  partial_sort(s.begin(),s.begin()+min<size_t>(nbest,s.size()),s.end(),
+               Comparator());
 
   vector<pair<node_t,value_t> >::const_iterator
     it=s.begin(),itend=s.end();
 
+  // Rankings without a method name are intermediate steps
+  ostream &o=method.empty()?out.steps:out.stream;
+
   if(nbest==0){
     node_t i;
     for(i=0;it!=itend&&it->second>0;++i,++it){
-      cout<<g.getLabel(it->first)<<" "<<it->second<<endl;
+      o<<g.getLabel(it->first)<<" "<<it->second<<endl;
     }
-    cout<<"These were the "<<i<<" best ones"<<endl;
+    o<<"These were the "<<i<<" best ones"<<endl;
   }else{
     for(node_t i=0;i<nbest&&it!=itend&&it->second>0.;++i,++it){
-      cout<<(IsLinked(g,base_article,it->first)?"*":"")<<g.getLabel(it->first)<<" "<<it->second<<endl;
+      o<<(IsLinked(g,base_article,it->first)?"*":"")<<g.getLabel(it->first)<<" "<<it->second<<endl;
     }
   }
  
-  if(!method.empty())
+  if(!method.empty() && out.ranking){
+    partial_sort(s.begin(),s.begin()+min<size_t>(out.nbRanked,s.size()),
+                 s.end(),Comparator());
+    out.ranking->clear();
+    for(it=s.begin();
+        out.ranking->size()<out.nbRanked&&it!=itend&&it->second>0.;++it){
+      // Methods may rank the nodes of a subgraph
+      node_t j=&g==out.graph?it->first:
+        out.graph->getNodeWithLabel(g.getLabel(it->first));
+      if(j!=(node_t)-1)
+        out.ranking->push_back(make_pair(j,it->second));
+    }
+  }else if(!method.empty() && out.evaluation)
     addResultsToFileForSQLImport("../evaluation",method,base_article,g,v,30);
 }
 
@@ -113,14 +216,14 @@ void addResultsToFileForSQLImport(const string &filename,
                                   const T&v,
                                   unsigned nb)
 {
+  lock_guard<mutex> lock(evaluationMutex);
   ofstream out(filename.c_str(),ios::app);
  
-  vector<pair<node_t,value_t> > s(v.size());
-  for(node_t i=0;i<v.size();++i){
-    s[i]=make_pair(i,v[i]);
-  }
+  vector<pair<node_t,value_t> > s;
+  getEntries(v,s);
 
-  partial_sort(s.begin(),s.begin()+nb,s.end(),Comparator());
+  partial_sort(s.begin(),s.begin()+min<size_t>(nb,s.size()),s.end(),
+               Comparator());
 
   vector<pair<node_t,value_t> >::const_iterator
     it=s.begin(),itend=s.end();
@@ -154,10 +257,11 @@ void addResultsToFileForSQLImport(const string &filename,
 
 unsigned int NForwardCocitation(const Graph&g,unsigned i,unsigned j)//Number of common links between nodes i and j
 {
-  static node_t previousi=0;static bool flag=false;
-  static vector<bool> v;//indicates which nodes are pointed to by previousi
-  if(i!=previousi||!flag){
-    flag=true;previousi=i;
+  thread_local node_t previousi=0;thread_local bool flag=false;
+  thread_local const Graph *previousg=0;
+  thread_local vector<bool> v;//indicates which nodes are pointed to by previousi
+  if(i!=previousi||&g!=previousg||!flag){
+    flag=true;previousi=i;previousg=&g;
     v=vector<bool> (g.getNbNodes(),0);
     for(SparseArray::const_iterator it=g.row(i).begin(),itend=g.row(i).end();
         it!=itend;++it){
@@ -172,10 +276,11 @@ unsigned int NForwardCocitation(const Graph&g,unsigned i,unsigned j)//Number of
 
 unsigned int NBackwardCocitation(const Graph&g,unsigned i,unsigned j)//Number of nodes pointing to both i and j
 {
-  static node_t previousi=0;static bool flag=false;
-  static vector<bool> v;//indicates which nodes are pointed to by previousi
-  if(i!=previousi||!flag){
-    flag=true;previousi=i;
+  thread_local node_t previousi=0;thread_local bool flag=false;
+  thread_local const Graph *previousg=0;
+  thread_local vector<bool> v;//indicates which nodes are pointed to by previousi
+  if(i!=previousi||&g!=previousg||!flag){
+    flag=true;previousi=i;previousg=&g;
     v=vector<bool> (g.getNbNodes(),false);
     for(SparseArray::const_iterator it=g.column(i).begin(),itend=g.column(i).end();
         it!=itend;++it){
@@ -188,7 +293,7 @@ unsigned int NBackwardCocitation(const Graph&g,unsigned i,unsigned j)//Number of
   return c;
 }
 
-void ForwardPagerank(const Graph& g,node_t node,Vector&v,const RowVector&eq)
+void ForwardPagerank(const Graph& g,node_t node,Vector&v,const MappedVector &eq)
 {
  for(SparseArray::const_iterator j=g.row(node).begin(),jend=g.row(node).end();
 		 j!=jend;
@@ -198,7 +303,7 @@ void ForwardPagerank(const Graph& g,node_t node,Vector&v,const RowVector&eq)
  return;
 }
 
-void BackPagerank(const Graph& g,node_t node,Vector&v,const RowVector&eq)
+void BackPagerank(const Graph& g,node_t node,Vector&v,const MappedVector &eq)
 {
  for(SparseArray::const_iterator j=g.column(node).begin(),jend=g.column(node).end();
 		 j!=jend;
@@ -236,7 +341,7 @@ void nodearraytfidf(const Graph&g,node_t node,NodeArray& a)
  }
 }
 
-void nodearraytfinfo(const Graph&g,node_t node,NodeArray& a,const RowVector& eqm)
+void nodearraytfinfo(const Graph&g,node_t node,NodeArray& a,const MappedVector &eqm)
 {
  a.clear();
  for(SparseArray::const_iterator j=g.row(node).begin(),jend=g.row(node).end();
@@ -247,35 +352,31 @@ void nodearraytfinfo(const Graph&g,node_t node,NodeArray& a,const RowVector& eqm
 
 void SomeNeighborhood(const Graph&g, node_t node, NodeArray& a)
 {
- NodeArray n;
- directedSphere(g,node,"",a);
- directedSphere(g,node,"F",n);
- addNodeArray(a,n,a);
- directedSphere(g,node,"FB",n);
- addNodeArray(a,n,a);
- directedSphere(g,node,"B",n);
- addNodeArray(a,n,a);
- directedSphere(g,node,"BF",n);
- addNodeArray(a,n,a);
+ const char *directions[]={"","F","FB","B","BF"};
+ vector<NodeArray> n;
+ directedSpheres(g,node,vector<string>(directions,directions+5),n);
+ a=n[0];
+ for(unsigned k=1;k<n.size();++k)
+	 addNodeArray(a,n[k],a);
 }
 
-void PageRankOfLinks(const Graph&g, node_t node, const RowVector& v)
+void PageRankOfLinks(Output &out,const Graph&g, node_t node, const MappedVector &v)
 {
  RowVector v2(v.size());
  for(SparseArray::const_iterator i=g.row(node).begin(),iend=g.row(node).end();
 		 i!=iend;++i)v2[i.index()]=v[i.index()];
  v2[node]=v[node];
- PrintNamesOfBest(g,v2,30u,"PageRankOfLinks",node);
+ PrintNamesOfBest(out,g,v2,30u,"PageRankOfLinks",node);
 }
 
-void NeighborhoodPageRank(const Graph&g, node_t node, const RowVector& eq)
+void NeighborhoodPageRank(Output &out,const Graph&g, node_t node, const MappedVector &eq)
 {
  NodeArray n;
- cerr<<"Computing desired neighborhood"<<endl;
+ out.log<<"Computing desired neighborhood"<<endl;
  SomeNeighborhood(g,node,n);
  unsigned int size=g.getNbNodes();
- cerr<<n.size()<<endl;
- cerr<<"Extracting subgraph"<<endl;
+ out.log<<n.size()<<endl;
+ out.log<<"Extracting subgraph"<<endl;
  vector<bool> whichnodes(size,false);
  for(SparseArray::iterator i=n.begin(),iend=n.end();
 		 i!=iend;++i)if(i.value())whichnodes[i.index()]=true;
@@ -285,31 +386,31 @@ void NeighborhoodPageRank(const Graph&g, node_t node, const RowVector& eq)
    for(node_t i=0,c=0;i<size;++i)if(whichnodes[i])v2[c++]=eq[i];
  PackedGraph ng(f.name());
  node_t nnode=ng.getNodeWithLabel(g.getLabel(node));
- if(nnode==(node_t)(-1))cerr<<"This should not happen"<<endl;
+ if(nnode==(node_t)(-1))out.log<<"This should not happen"<<endl;
  unsigned int nsize=ng.getNbNodes();
- cerr<<ng.getNbNodes()<<endl;
- cerr<<"Computing its strongly connected components"<<endl;
+ out.log<<ng.getNbNodes()<<endl;
+ out.log<<"Computing its strongly connected components"<<endl;
  vector<node_t> comp(nsize);
  stronglyConnectedComponents(ng,comp);
- cerr<<"Extracting subsubgraph"<<endl;
+ out.log<<"Extracting subsubgraph"<<endl;
  node_t compnum=comp[nnode];
  whichnodes=vector<bool> (nsize,false);
  for(node_t i=0;i<nsize;++i)if(comp[i]==compnum)whichnodes[i]=true;
  MutableGraph ngc(ng,whichnodes);
  ng.destroy();
    for(node_t i=0,c=0;i<nsize;++i)if(whichnodes[i])v2[c++]=v2[i];
- nsize=ngc.getNbNodes();cerr<<nsize<<endl;
- cerr<<"Stochastifying rows"<<endl;
+ nsize=ngc.getNbNodes();out.log<<nsize<<endl;
+ out.log<<"Stochastifying rows"<<endl;
  stochastifyRows(ngc);
- cerr<<"Computing invariant measure"<<endl;
+ out.log<<"Computing invariant measure"<<endl;
  RowVector v(nsize);for(node_t i=0;i<nsize;++i)v[i]=1./nsize;
  for(int t=0;t<10;t++){
 	 v=v*ngc;
-	 cerr<<endl<<t<<" "<<endl;
+	 out.log<<endl<<t<<" "<<endl;
 //	 PrintNamesOfBest(ngc,v,30u);
  }
 
- cerr<<endl;
+ out.log<<endl;
  //RowVector v2(nsize);
 // for(node_t i=0;i<nsize;++i){
 //	 v2[i]=eq[g.getNodeWithLabel(ngc.getLabel(i))];
@@ -317,102 +418,77 @@ void NeighborhoodPageRank(const Graph&g, node_t node, const RowVector& eq)
 // }
  //value_t s=0;for(node_t i=0;i<nsize;++i)s+=v2[i];
  //for(node_t i=0;i<nsize;++i)v[i]-=v2[i]/s;
- PrintNamesOfBest(ngc,v,30u,"NeighborhoodPageRank",
+ PrintNamesOfBest(out,ngc,v,30u,"NeighborhoodPageRank",
                   ngc.getNodeWithLabel(g.getLabel(node)));
 }
 
-void NCocitations(const Graph& g, node_t node)
+void NCocitations(Output &out,const Graph& g, node_t node)
 {
  NodeArray n;directedSphere(g,node,"BF",n);
- vector<unsigned int> cocit(g.getNbNodes(),0);
+ FrontierVector &cocit=scratch(0,g.getNbNodes());
  for(SparseArray::iterator i=n.begin(),iend=n.end();
 		 i!=iend;++i){
-	 cocit[i.index()]=NBackwardCocitation(g,node,i.index());
+	 cocit.set(i.index(),NBackwardCocitation(g,node,i.index()));
 	 //cocit[j]=NForwardCocitation(g,node,j);
 	 //cocit[j]=NForwardCocitation(g,node,j)+NBackwardCocitation(g,node,j);
  }
- PrintNamesOfBest(g,cocit,30u,"NCocitations",node);
+ PrintNamesOfBest(out,g,cocit,30u,"NCocitations",node);
 }
 
-void FSiblings(const Graph&g,node_t node,const RowVector& v)
+void FSiblings(Output &out,const Graph&g,node_t node,const MappedVector &v)
 {
  unsigned int size=g.getNbNodes();
- RowVector delta(size);delta[node]=1;
- delta=delta*g;
- ColumnVector f(size);
- for(node_t i=0;i<size;++i)f[i]=delta[i]/v[i];
- f=g*f;
- for(node_t i=0;i<size;++i)delta[i]=f[i]*v[i];//*log(1./v[i]);
- PrintNamesOfBest(g,delta,30u,"FSiblings",node);
- cout<<endl;
+ FrontierVector &delta=scratch(0,size),&next=scratch(1,size),&f=scratch(2,size);
+ delta.set(node,1);
+ multiply(delta,g,next);
+ next.forEach([&](node_t i,double x){f.set(i,x/v[i]);});
+ multiply(g,f,next);
+ delta.clear();
+ next.forEach([&](node_t i,double x){delta.set(i,x*v[i]);});//*log(1./v[i]);
+ PrintNamesOfBest(out,g,delta,30u,"FSiblings",node);
+ out<<endl;
 }
 
-void BSiblings(const Graph&g,node_t node,const RowVector& v)
+void BSiblings(Output &out,const Graph&g,node_t node,const MappedVector &v)
 {
  unsigned int size=g.getNbNodes();
- ColumnVector fdelta(size);fdelta[node]=1/v[node];
- fdelta=g*fdelta;
- RowVector m(size);
- for(node_t i=0;i<size;++i)m[i]=fdelta[i]*v[i];
- m=m*g;
- PrintNamesOfBest(g,m,30u,"BSiblings",node);
- cout<<endl;
+ FrontierVector &fdelta=scratch(0,size),&next=scratch(1,size),&m=scratch(2,size);
+ fdelta.set(node,1/v[node]);
+ multiply(g,fdelta,next);
+ next.forEach([&](node_t i,double x){m.set(i,x*v[i]);});
+ multiply(m,g,next);
+ PrintNamesOfBest(out,g,next,30u,"BSiblings",node);
+ out<<endl;
 }
 
-void FBSiblings(const Graph&g,node_t node,const RowVector& v)
+void FBSiblings(Output &out,const Graph&g,node_t node,const MappedVector &v)
 {
  unsigned int size=g.getNbNodes();
- RowVector delta(size);delta[node]=1;
- delta=delta*g;
- ColumnVector f(size);
- for(node_t i=0;i<size;++i)f[i]=delta[i]/v[i];
- f=g*f;
- for(node_t i=0;i<size;++i)delta[i]=f[i]*v[i];
- ColumnVector fdelta(size);fdelta[node]=1/v[node];
- fdelta=g*fdelta;
- RowVector m(size);
- for(node_t i=0;i<size;++i)m[i]=fdelta[i]*v[i];
- m=m*g;
- m+=delta;
- PrintNamesOfBest(g,m,30u,"FBSiblings",node);
- cout<<endl;
-}
-
-void CosineMethod(const Graph&g,node_t node,const RowVector&)
+ FrontierVector &delta=scratch(0,size),&next=scratch(1,size),&f=scratch(2,size);
+ delta.set(node,1);
+ multiply(delta,g,next);
+ next.forEach([&](node_t i,double x){f.set(i,x/v[i]);});
+ multiply(g,f,next);
+ delta.clear();
+ next.forEach([&](node_t i,double x){delta.set(i,x*v[i]);});
+ FrontierVector &m=scratch(3,size);
+ f.clear();f.set(node,1/v[node]);
+ multiply(g,f,next);
+ next.forEach([&](node_t i,double x){m.set(i,x*v[i]);});
+ multiply(m,g,next);
+ delta.forEach([&](node_t i,double x){next.add(i,x);});
+ PrintNamesOfBest(out,g,next,30u,"FBSiblings",node);
+ out<<endl;
+}
+
+void CosineMethod(Output &out,const Graph&g,node_t node,const TfIdf &weights)
 {
- unsigned int size=g.getNbNodes();
- NodeArray spherefb;directedSphere(g,node,"FB",spherefb);
- unsigned int spheresize=count(spherefb.begin(),spherefb.end(),1),c=0;
- cerr<<spheresize<<endl;
- NodeArray nv1,nv2;vector<value_t> cosines(size);
-// nodearraytf(g,node,nv1);
-// for(SparseArray::iterator j=spherefb.begin(),jend=spherefb.end();
-//		 j!=jend;++j,++c){
-//	 nodearraytf(g,j.index(),nv2);
-//	 cosines[j.index()]=cos2(nv1,nv2);
-//	 if(!(c%10000))cerr<<c<<endl;
-// }
-// PrintNamesOfBest(g,cosines,30u);
-// cout<<endl;
-// cosines=vector<value_t>(size,0.);c=0;
- nodearraytfidf(g,node,nv1);
- for(SparseArray::iterator j=spherefb.begin(),jend=spherefb.end();
-		 j!=jend;++j,++c){
-	 nodearraytfidf(g,j.index(),nv2);
-	 cosines[j.index()]=cos2(nv1,nv2);
-	 if(!(c%10000))cerr<<c<<endl;
- }
- PrintNamesOfBest(g,cosines,30u,"Cosine",node);
- cout<<endl;
-// cosines=vector<value_t>(size,0.);c=0;
-// nodearraytfinfo(g,node,nv1,v);
-// for(SparseArray::iterator j=spherefb.begin(),jend=spherefb.end();
-//		 j!=jend;++j,++c){
-//	 nodearraytfinfo(g,j.index(),nv2,v);
-//	 cosines[j.index()]=cos2(nv1,nv2);
-//	 if(!(c%10000))cerr<<c<<endl;
-// }
-// PrintNamesOfBest(g,cosines,30u);
+ // Cosines of TF-IDF vectors with all nodes of the FB sphere at once
+ FrontierVector &cosines=scratch(0,g.getNbNodes());
+ weights.cosines(node,cosines);
+ out.log<<cosines.support().size()<<endl;
+ PrintNamesOfBest(out,g,cosines,30u,"Cosine",node);
+ out<<endl;
 }
 
 //void Green(const Graph&g,node_t node,const RowVector&v,unsigned int nsteps=20)
@@ -449,63 +525,65 @@ void CosineMethod(const Graph&g,node_t node,const RowVector&)
 //	 PrintNamesOfBest(g,info,30u,"Green",node);cout<<endl;
 //}
 
-void Green(const Graph&g,node_t node,const RowVector&v,unsigned int nsteps=20,value_t alpha=0)
+void Green(Output &out,const Graph&g,node_t node,const MappedVector &v,unsigned int nsteps=20,value_t alpha=0)
 {
- cerr<<"Computing pages related to \""<<g.getLabel(node)<<"\" using the Green method"<<endl;
+ out.log<<"Computing pages related to \""<<g.getLabel(node)<<"\" using the Green method"<<endl;
  node_t size=g.getNbNodes();
- RowVector greenmeasure(size),deltan(size);ColumnVector ddeltan(size);
- Vector info(size);
+ // Walks from node only reach part of the graph in the first steps:
+ // only coordinates in the support of deltan can be positive in info
+ FrontierVector &deltan=scratch(0,size),&next=scratch(1,size);
+ FrontierVector &info=scratch(2,size);
+ FrontierVector &d=scratch(3,size),&ddeltan=scratch(4,size);
  //Vector meangeom(size);
- deltan[node]=1;
+ deltan.set(node,1);
  for(node_t i=0;i<nsteps;++i){
-	 cout<<i<<endl;
+	 out.steps<<i<<endl;
 	 if(alpha){
-		 for(node_t j=0;j<size;j++)ddeltan[j]=deltan[j]/v[j];
-		 ddeltan=g*ddeltan;
+		 d.clear();
+		 deltan.forEach([&](node_t j,double x){d.set(j,x/v[j]);});
+		 multiply(g,d,ddeltan);
 	 }
-	 deltan=deltan*g;
+	 multiply(deltan,g,next);
 	 if(alpha){
-		 for(node_t j=0;j<size;j++)deltan[j]=(1.-alpha)*deltan[j]+alpha*ddeltan[j]*v[j];
-	 }
-	 deltan[node]+=1;
+		 deltan.clear();
+		 next.forEach([&](node_t j,double x){deltan.add(j,(1.-alpha)*x);});
+		 ddeltan.forEach([&](node_t j,double x){deltan.add(j,alpha*x*v[j]);});
+	 }else
+		 swap(deltan,next);
+	 deltan.add(node,1);
 	 //mass(deltan)==i+2
-	 for(node_t j=0;j<size;j++)greenmeasure[j]=deltan[j]-(i+2)*v[j];
-	 for(node_t j=0;j<size;j++)info[j]=greenmeasure[j]*log(1/v[j])/log(1/v[node]);
+	 info.clear();
+	 deltan.forEach([&](node_t j,double x){
+		 double greenmeasure=x-(i+2)*v[j];
+		 info.set(j,greenmeasure*log(1/v[j])/log(1/v[node]));
+	 });
 	 //for(node_t j=0;j<size;j++)meangeom[j]=greenmeasure[j]/sqrt(v[j])*sqrt(v[node]);
-	 PrintNamesOfBest(g,info,30u,"",node);cout<<endl;
+	 PrintNamesOfBest(out,g,info,30u,"",node);out.steps<<endl;
 	 //PrintNamesOfBest(g,meangeom,30u,"",node);cout<<endl;
 	 //PrintNamesOfBest(g,greenmeasure,30u);cout<<endl;
-	 unsigned c=0;for(node_t j=0;j<size;j++)if(deltan[j]>0)++c;
-	 cout<<c<<" nonzero values"<<endl;
+	 unsigned c=0;deltan.forEach([&](node_t,double x){if(x>0)++c;});
+	 out.steps<<c<<" nonzero values"<<endl;
  }
-	 PrintNamesOfBest(g,info,30u,"Green",node);cout<<endl;
+	 PrintNamesOfBest(out,g,info,30u,"Green",node);out<<endl;
 }
 
-void PersonPR(const Graph&g,node_t node,const RowVector&v,unsigned int nsteps=20)
+void PersonPR(Output &out,const Graph&g,node_t node,const MappedVector &v,double epsilon=1e-7)
 {
- cerr<<"Computing pages related to \""<<g.getLabel(node)<<"\" using the PPR method"<<endl;
- node_t size=g.getNbNodes();
+ out.log<<"Computing pages related to \""<<g.getLabel(node)<<"\" using the PPR method"<<endl;
  double c=0.15;
- RowVector greenmeasure(size),greenmeasure0(size);
- Vector info(size);
- greenmeasure0[node]=1;
- greenmeasure=greenmeasure0;
- for(node_t i=0;i<nsteps;++i){
-	 cout<<i<<endl;
-	 greenmeasure=(1.-c)*(greenmeasure*g);//(1./3.)*(g*greenmeasure)+(2./3.)*(h*greenmeasure);
-	 greenmeasure+=c*greenmeasure0;
-	 //SYMMETRIC CASE ONLY
-	 for(node_t j=0;j<size;j++)info[j]=1./c*greenmeasure[j]*log(1/v[j])/log(1/v[node]);
-	 PrintNamesOfBest(g,info,30u,"",node);cout<<endl;
-	 unsigned c=0;for(node_t j=0;j<size;j++)if(info[j]>0)++c;
-	 cout<<c<<" positive values"<<endl;
- }
-	 PrintNamesOfBest(g,info,30u,"PPR",node);cout<<endl;
+ NodeArray greenmeasure;
+ unsigned long pushes=PersonalizedPageRank(g,node,greenmeasure,epsilon,1.-c);
+ out.log<<pushes<<" pushes, "<<greenmeasure.size()<<" nodes reached"<<endl;
+ NodeArray info;
+ //SYMMETRIC CASE ONLY
+ for(SparseArray::iterator it=greenmeasure.begin(),itend=greenmeasure.end();it!=itend;++it)
+	 info.insert(it.index(),1./c* *it*log(1/v[it.index()])/log(1/v[node]));
+ PrintNamesOfBest(out,g,info,30u,"PPR",node);out<<endl;
 }
 
-void Hittingtime(const Graph&g,node_t node,const RowVector&v,unsigned int nsteps=20)
+void Hittingtime(Output &out,const Graph&g,node_t node,const MappedVector &v,unsigned int nsteps=20)
 {
- cerr<<"Computing pages related to \""<<g.getLabel(node)<<"\" using the Inverse Hitting Time method"<<endl;
+ out.log<<"Computing pages related to \""<<g.getLabel(node)<<"\" using the Inverse Hitting Time method"<<endl;
  node_t size=g.getNbNodes();
  ColumnVector greenfunc(size),greenfunc0(size);Vector bla(size);
  for(node_t j=0;j<size;j++)greenfunc0[j]=-1;
@@ -513,7 +591,7 @@ void Hittingtime(const Graph&g,node_t node,const RowVector&v,unsigned int nsteps
  for(node_t j=0;j<size;j++)greenfunc[j]=-100.;
  greenfunc[node]=0;
  for(node_t i=0;i<nsteps;++i){
-	 cout<<i<<endl;
+	 out.steps<<i<<endl;
 	 //cout<<greenmeasure.variance()<<endl;
 	 greenfunc=g*greenfunc;
 	 greenfunc+=greenfunc0;greenfunc[node]=0;
@@ -526,83 +604,575 @@ void Hittingtime(const Graph&g,node_t node,const RowVector&v,unsigned int nsteps
 	 for(node_t j=0;j<size;j++)bla[j]=v[j]*exp(greenfunc[j]);
 	 //PrintNamesOfBest(g,greenfunc,30u);cout<<endl;
 	 //PrintNamesOfBest(g,meangeom,30u);cout<<endl;
-	 PrintNamesOfBest(g,bla,30u,"",node);cout<<endl;
+	 PrintNamesOfBest(out,g,bla,30u,"",node);out.steps<<endl;
 	 //PrintNamesOfBest(g,greenmeasure,30u);cout<<endl;
  }
-	 PrintNamesOfBest(g,bla,30u,"Hittingtime",node);cout<<endl;
+	 PrintNamesOfBest(out,g,bla,30u,"Hittingtime",node);out<<endl;
+}
+
+// Graphs and equilibrium measure, loaded once and shared (read-only) by
+// all queries
+class Session {
+  public:
+    // Graphs are mapped read-only, so that processes can share them
+    Session(bool populate=false);
+    ~Session();
+
+    const Graph &graph(const string &method);
+    const MappedVector &measure();
+    const TfIdf &weights(const Graph &g);
+
+    // Answers a query: "OK n" followed by n lines of results, or
+    // "ERROR message"
+    string answer(const string &word, const string &method);
+    void run(Output &out,const string &word, const string &method);
+
+    // Writes the k best related nodes of every node, as given by
+    // method, as the rows of a graph; method can then be replaced by
+    // this file in queries
+    bool buildIndex(const string &method,const string &filename,node_t k);
+
+  private:
+    void runMethod(Output &out,const Graph &g,node_t node,
+                   const string &method);
+    void runIndex(Output &out,const Graph &index,const string &word);
+
+    Session(const Session&);
+    Session &operator=(const Session&);
+
+    mutex m;
+    PackedGraphOptions mapping;
+    map<string,PackedGraph*> graphs;
+    map<const Graph*,TfIdf*> tfidfs;
+    MappedVector *v=0;
+};
+
+Session::Session(bool populate)
+{
+  mapping.readOnly=true;
+  mapping.populate=populate;
+  mapping.access=ACCESS_RANDOM;
+}
+
+Session::~Session()
+{
+  for(map<const Graph*,TfIdf*>::iterator it=tfidfs.begin();
+      it!=tfidfs.end();++it)
+    delete it->second;
+  for(map<string,PackedGraph*>::iterator it=graphs.begin();
+      it!=graphs.end();++it)
+    delete it->second;
+  delete v;
+}
+
+// Queries can be answered from an index built by -index, given instead
+// of the method
+static bool isIndex(const string &method)
+{
+  return method.size()>4 && method.compare(method.size()-4,4,".gph")==0;
+}
+
+static string graphFile(const string &method)
+{
+  if(isIndex(method))
+    return method;
+
+  string name="graph.firstscc.norm";
+  if(method=="GreenSym")
+    name+=".sym";
+  else if(method=="Hittingtime")
+    name+=".rev";
+
+  // Variants of the graph may be stored as value files, sharing the
+  // structure of another graph file
+  if(access((name+".gpv").c_str(),R_OK)==0)
+    return name+".gpv";
+  return name+".gph";
+}
+
+const Graph &Session::graph(const string &method)
+{
+  string filename=graphFile(method);
+
+  lock_guard<mutex> lock(m);
+  PackedGraph *&pg=graphs[filename];
+  if(!pg) {
+    pg=new PackedGraph(filename,mapping);
+    if(!pg->isOk()) {
+      delete pg;
+      pg=0;
+      throw domain_error("Impossible to load the graph "+filename);
+    }
+    cerr << "Number of nodes: " << pg->getNbNodes() << endl;
+    cerr << "Number of edges: " << pg->getNbEdges() << endl;
+  }
+
+  return *pg;
+}
+
+const MappedVector &Session::measure()
+{
+  lock_guard<mutex> lock(m);
+  if(!v) {
+    cerr<<"Loading equilibrium measure"<<endl;
+    v=new MappedVector("graph.firstscc.150.msr");
+    if(!v->isOk()) {
+      delete v;
+      v=0;
+      throw domain_error("Impossible to load the equilibrium measure");
+    }
+  }
+
+  return *v;
+}
+
+const TfIdf &Session::weights(const Graph &g)
+{
+  lock_guard<mutex> lock(m);
+  TfIdf *&w=tfidfs[&g];
+  if(!w) {
+    cerr<<"Computing TF-IDF weights"<<endl;
+    w=new TfIdf(g);
+  }
+
+  return *w;
+}
+
+void Session::run(Output &out,const string &word, const string &method)
+{
+  const Graph &g=graph(method);
+
+  if(isIndex(method)) {
+    runIndex(out,g,word);
+    return;
+  }
+
+  node_t node=g.getNodeWithLabel(word);
+  if(node==(node_t)-1)
+    throw domain_error("No node with this label");
+//  cerr<<endl<<"Edges from "<<argv[1]<<endl;
+//  PrintLinksFrom(g,node);
+//  cerr<<endl<<"Edges to "<<argv[1]<<endl;
+//  PrintLinksTo(g,node);
+//  return 0;
+
+  runMethod(out,g,node,method);
+}
+
+// Methods by name; the equilibrium measure is only loaded by the
+// methods using it
+struct Method {
+  const char *name;
+  void (*run)(Output &out,Session &s,const Graph &g,node_t node);
+};
+
+static const Method methods[]={
+  {"PageRankOfLinks",[](Output &out,Session &s,const Graph &g,node_t node) {
+    PageRankOfLinks(out,g,node,s.measure()); }},
+  {"NeighborhoodPageRank",
+   [](Output &out,Session &s,const Graph &g,node_t node) {
+    NeighborhoodPageRank(out,g,node,s.measure()); }},
+  {"NCocitations",[](Output &out,Session &,const Graph &g,node_t node) {
+    NCocitations(out,g,node); }},
+  {"Cosine",[](Output &out,Session &s,const Graph &g,node_t node) {
+    CosineMethod(out,g,node,s.weights(g)); }},
+  {"Green",[](Output &out,Session &s,const Graph &g,node_t node) {
+    Green(out,g,node,s.measure(),5); }},
+  {"GreenSym",[](Output &out,Session &s,const Graph &g,node_t node) {
+    Green(out,g,node,s.measure(),5); }},
+  {"BSiblings",[](Output &out,Session &s,const Graph &g,node_t node) {
+    BSiblings(out,g,node,s.measure()); }},
+  {"FSiblings",[](Output &out,Session &s,const Graph &g,node_t node) {
+    FSiblings(out,g,node,s.measure()); }},
+  {"FBSiblings",[](Output &out,Session &s,const Graph &g,node_t node) {
+    FBSiblings(out,g,node,s.measure()); }},
+  {"Hittingtime",[](Output &out,Session &s,const Graph &g,node_t node) {
+    Hittingtime(out,g,node,s.measure(),10); }},
+  {"PPR",[](Output &out,Session &s,const Graph &g,node_t node) {
+    PersonPR(out,g,node,s.measure()); }}
+};
+
+static const Method *findMethod(const string &name)
+{
+  for(size_t k=0;k<sizeof(methods)/sizeof(methods[0]);++k)
+    if(name==methods[k].name)
+      return &methods[k];
+
+  return 0;
+}
+
+void Session::runMethod(Output &out,const Graph &g,node_t node,
+                        const string &method)
+{
+  const Method *m=findMethod(method);
+  if(!m)
+    throw std::logic_error("Bad method name");
+
+  m->run(out,*this,g,node);
+}
+
+void Session::runIndex(Output &out,const Graph &index,const string &word)
+{
+  node_t node=index.getNodeWithLabel(word);
+  if(node==(node_t)-1)
+    throw domain_error("No node with this label");
+
+  // Links are those of the main graph
+  const Graph &g=graph("");
+  node_t base=g.getNodeWithLabel(word);
+
+  vector<pair<node_t,value_t> > s;
+  const EdgeSpan<const value_t> r=index.rowEdges(node);
+  for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+      it!=itend;++it)
+    s.push_back(make_pair(it.index(),*it));
+  sort(s.begin(),s.end(),Comparator());
+
+  for(vector<pair<node_t,value_t> >::const_iterator it=s.begin();
+      it!=s.end();++it)
+    out<<(base!=(node_t)-1&&IsLinked(g,base,it->first)?"*":"")
+       <<index.getLabel(it->first)<<" "<<it->second<<endl;
+}
+
+bool Session::buildIndex(const string &method,const string &filename,
+                         node_t k)
+{
+  if(!findMethod(method))
+    throw std::logic_error("Bad method name");
+
+  // Shared data is loaded before workers start
+  const Graph &g=graph(method);
+  const node_t size=g.getNbNodes();
+  measure();
+  if(method=="Cosine")
+    weights(g);
+
+  // Queries only read rows of the index
+  GraphBuilder builder(filename,size,GraphBuilder::DEFAULT_MEMORY,false);
+  if(!builder.isOk())
+    return false;
+
+  // Workers run single-threaded methods (see ParallelRegion), with
+  // quiet outputs
+  const unsigned nbThreads=getNbThreads();
+  const node_t CHUNK_SIZE=16;
+  atomic<node_t> next(0);
+  mutex logMutex;
+  unsigned failed=0;
+
+  runInParallel(nbThreads,[&](unsigned) {
+    GraphBuilder::Inserter inserter(builder,nbThreads);
+    ostream null(0);
+    vector<pair<node_t,value_t> > ranking;
+
+    for(;;) {
+      const node_t begin=next.fetch_add(CHUNK_SIZE);
+      if(begin>=size)
+        break;
+      const node_t end=min<node_t>(size,begin+CHUNK_SIZE);
+
+      for(node_t i=begin;i<end;++i) {
+        ranking.clear();
+        Output out(null,g,ranking,k);
+        try {
+          runMethod(out,g,i,method);
+        } catch(const exception &e) {
+          lock_guard<mutex> lock(logMutex);
+          cerr<<g.getLabel(i)<<": "<<e.what()<<endl;
+          ++failed;
+          continue;
+        }
+
+        sort(ranking.begin(),ranking.end());
+        for(vector<pair<node_t,value_t> >::const_iterator
+              it=ranking.begin();it!=ranking.end();++it)
+          inserter.add(i,it->first,it->second);
+      }
+
+      if(begin/CHUNK_SIZE%1000==0) {
+        lock_guard<mutex> lock(logMutex);
+        cerr<<begin<<" nodes"<<endl;
+      }
+    }
+  });
+
+  if(failed)
+    cerr<<failed<<" nodes without results"<<endl;
+
+  if(g.hasLabels())
+    for(node_t i=0;i<size;++i)
+      builder.addLabel(g.getLabel(i));
+
+  return builder.close();
+}
+
+string Session::answer(const string &word, const string &method)
+{
+  ostringstream stream;
+  Output out(stream,false);
+  try {
+    run(out,word,method);
+  } catch(const exception &e) {
+    return string("ERROR ")+e.what()+"\n";
+  }
+
+  string result=stream.str();
+  if(!result.empty() && result[result.size()-1]!='\n')
+    result+='\n';
+
+  ostringstream header;
+  header << "OK " << count(result.begin(),result.end(),'\n') << "\n";
+
+  return header.str()+result;
+}
+
+// Fixed set of worker threads answering queries of all connections
+class QueryPool {
+  public:
+    QueryPool(Session &s, unsigned nbThreads);
+    ~QueryPool();
+
+    future<string> submit(const string &word, const string &method);
+
+  private:
+    void work();
+
+    Session &session;
+    mutex m;
+    condition_variable cv;
+    deque<packaged_task<string()> > tasks;
+    vector<thread> workers;
+    bool stopping=false;
+};
+
+QueryPool::QueryPool(Session &s, unsigned nbThreads) : session(s)
+{
+  for(unsigned t=0;t<nbThreads;++t)
+    workers.push_back(thread(&QueryPool::work,this));
+}
+
+QueryPool::~QueryPool()
+{
+  {
+    lock_guard<mutex> lock(m);
+    stopping=true;
+  }
+  cv.notify_all();
+  for(unsigned t=0;t<workers.size();++t)
+    workers[t].join();
+}
+
+future<string> QueryPool::submit(const string &word, const string &method)
+{
+  Session &s=session;
+  packaged_task<string()> task([&s,word,method]() {
+    return s.answer(word,method);
+  });
+  future<string> result=task.get_future();
+  {
+    lock_guard<mutex> lock(m);
+    tasks.push_back(std::move(task));
+  }
+  cv.notify_one();
+
+  return result;
+}
+
+void QueryPool::work()
+{
+  // Queries are computed with single-threaded products
+  ParallelRegion region;
+
+  for(;;) {
+    packaged_task<string()> task;
+    {
+      unique_lock<mutex> lock(m);
+      cv.wait(lock,[this]() { return stopping || !tasks.empty(); });
+      if(tasks.empty())
+        return;
+      task=std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
+
+static void writeAll(int fd, const string &s)
+{
+  for(size_t done=0;done<s.size();) {
+    ssize_t n=write(fd,s.data()+done,s.size()-done);
+    if(n<0) {
+      if(errno==EINTR)
+        continue;
+      return;
+    }
+    done+=n;
+  }
+}
+
+// Reads "word method" lines from in, and writes answers to out in the
+// order of the queries; queries are pipelined over the pool
+static void serve(QueryPool &pool, int in, int out)
+{
+  mutex m;
+  condition_variable cv;
+  deque<future<string> > pending;
+  bool done=false;
+
+  thread writer([&]() {
+    for(;;) {
+      future<string> answer;
+      {
+        unique_lock<mutex> lock(m);
+        cv.wait(lock,[&]() { return done || !pending.empty(); });
+        if(pending.empty())
+          return;
+        answer=std::move(pending.front());
+        pending.pop_front();
+      }
+      writeAll(out,answer.get());
+    }
+  });
+
+  FILE *f=fdopen(dup(in),"r");
+  char *line=0;
+  size_t size=0;
+  ssize_t len;
+  while(f && (len=getline(&line,&size,f))!=-1) {
+    string query(line,len);
+    query.erase(query.find_last_not_of(" \t\r\n")+1);
+
+    // The method is the last word, the label everything before
+    string::size_type space=query.find_last_of(" \t");
+    string word=space==string::npos?"":query.substr(0,space);
+    word.erase(word.find_last_not_of(" \t")+1);
+    word.erase(0,word.find_first_not_of(" \t"));
+    string method=space==string::npos?query:query.substr(space+1);
+
+    if(query.empty())
+      continue;
+
+    future<string> answer;
+    if(word.empty()) {
+      promise<string> p;
+      p.set_value("ERROR Query should be: word method\n");
+      answer=p.get_future();
+    } else
+      answer=pool.submit(word,method);
+
+    {
+      lock_guard<mutex> lock(m);
+      pending.push_back(std::move(answer));
+    }
+    cv.notify_one();
+  }
+  free(line);
+  if(f)
+    fclose(f);
+
+  {
+    lock_guard<mutex> lock(m);
+    done=true;
+  }
+  cv.notify_one();
+  writer.join();
+}
+
+static int runDaemon(const char *socketPath)
+{
+  // Graphs are read when loaded, not by the first queries
+  Session session(true);
+  try {
+    session.measure();
+    session.graph("");
+  } catch(const exception &e) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  QueryPool pool(session,getNbThreads());
+  signal(SIGPIPE,SIG_IGN);
+
+  if(!socketPath) {
+    serve(pool,0,1);
+    return EXIT_SUCCESS;
+  }
+
+  sockaddr_un addr;
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family=AF_UNIX;
+  if(strlen(socketPath)>=sizeof(addr.sun_path)) {
+    cerr << "Socket path too long" << endl;
+    return EXIT_FAILURE;
+  }
+  strcpy(addr.sun_path,socketPath);
+
+  int sock=socket(AF_UNIX,SOCK_STREAM,0);
+  unlink(socketPath);
+  if(sock<0 ||
+     bind(sock,reinterpret_cast<sockaddr*>(&addr),sizeof(addr))<0 ||
+     listen(sock,SOMAXCONN)<0) {
+    perror(socketPath);
+    return EXIT_FAILURE;
+  }
+  cerr << "Listening on " << socketPath << endl;
+
+  for(;;) {
+    int client=accept(sock,0,0);
+    if(client<0) {
+      if(errno==EINTR)
+        continue;
+      perror("accept");
+      return EXIT_FAILURE;
+    }
+
+    thread([&pool,client]() {
+      serve(pool,client,client);
+      close(client);
+    }).detach();
+  }
 }
 
 int main(int argc, char** argv)
 {
+ if(argc>=2 && argc<=3 && string(argv[1])=="-daemon")
+   return runDaemon(argc==3?argv[2]:0);
+
+ if(argc>=4 && argc<=5 && string(argv[1])=="-index") {
+   Session session;
+   try {
+     if(session.buildIndex(argv[2],argv[3],argc==5?atoi(argv[4]):30))
+       return EXIT_SUCCESS;
+     cerr << "Cannot build " << argv[3] << endl;
+   } catch(const exception &e) {
+     cerr << e.what() << endl;
+   }
+   return EXIT_FAILURE;
+ }
+
  if(argc!=3) {
-	 cerr << "Usage: " << argv[0] << " word method" << endl;
+	 cerr << "Usage: " << argv[0] << " word method|index" << endl;
+	 cerr << "       " << argv[0] << " -daemon [socket]" << endl;
+	 cerr << "       " << argv[0] << " -index method index [k]" << endl;
 	 return EXIT_FAILURE;
  }
 
  std::string word=argv[1];
  std::string method=argv[2];
 
- //  PackedGraph g(argv[1]);
- PackedGraph *pg;
- 
- if(method=="GreenSym")
-   pg=new PackedGraph("graph.firstscc.norm.sym.gph");
- else if(method=="Hittingtime")
-   pg=new PackedGraph("graph.firstscc.norm.rev.gph");
- else
-   pg=new PackedGraph("graph.firstscc.norm.gph");
-
- PackedGraph &g=*pg;
-
  // PackedGraph g("../wikipedia.firstscc.norm.gph");
  // PackedGraph sg("../wikipedia.firstscc.norm.sym.gph");
  // MutableGraph g=RandomGraph(100,0.1);
 
- if(!g.isOk()) {
-	 cerr << "Impossible to load the graph." << endl;
-	 perror("");
+ Session session;
+ try {
+   Output out(cout);
+   session.run(out,word,method);
+ } catch(const domain_error &e) {
+	 cerr << e.what() << endl;
 	 return EXIT_FAILURE;
  }
 
- node_t size=g.getNbNodes();
- cerr << "Number of nodes: " << size << endl;
- cerr << "Number of edges: " << g.getNbEdges() << endl;
-
- node_t node=g.getNodeWithLabel(argv[1]);
- if(node==(node_t)-1){cerr<<"No node with this label"<<endl;return EXIT_FAILURE;}
-//  cerr<<endl<<"Edges from "<<argv[1]<<endl;
-//  PrintLinksFrom(g,node);
-//  cerr<<endl<<"Edges to "<<argv[1]<<endl;
-//  PrintLinksTo(g,node);
-//  return 0;
-
- cerr<<"Loading equilibrium measure"<<endl;
- RowVector v("graph.firstscc.150.msr");
- //PrintNamesOfBest(g,v,200u);return 0;
-
- if(method=="PageRankOfLinks")
-   PageRankOfLinks(g,node,v);
- else if(method=="NeighborhoodPageRank")
-   NeighborhoodPageRank(g,node,v);
- else if(method=="NCocitations")
-   NCocitations(g,node);
- else if(method=="Cosine")
-   CosineMethod(g,node,v);
- else if(method=="Green"||method=="GreenSym")
-	 Green(g,node,v,5);
- else if(method=="BSiblings")
-	 BSiblings(g,node,v);
- else if(method=="FSiblings")
-	 FSiblings(g,node,v);
- else if(method=="FBSiblings")
-	 FBSiblings(g,node,v);
- else if(method=="Hittingtime")
-	 Hittingtime(g,node,v,10);
- else if(method=="PPR")
-	 PersonPR(g,node,v,5);
- else
-   throw std::logic_error("Bad method name");
-
 // RowVector w(size);w[node]=1.;
 // cout<<"1"<<endl;w=w*sg;
 // cout<<"2"<<endl;w=w*sg;
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "PackedGraph.h"
+#include "Reordering.h"
+#include "Vector.h"
+
+using namespace std;
+using namespace lsg;
+
+static int usage(const char *name)
+{
+  cerr << "Usage : " << name
+       << " graph graph_out degree|rcm|gorder [permutation]" << endl;
+  cerr << "   or : " << name
+       << " -measure permutation measure measure_out" << endl;
+  return EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+  if(argc==5 && string(argv[1])=="-measure") {
+    vector<node_t> permutation;
+    if(!loadPermutation(argv[2],permutation)) {
+      cerr << "Cannot load " << argv[2] << endl;
+      return EXIT_FAILURE;
+    }
+
+    RowVector v(argv[3]);
+    if(v.size()!=permutation.size()) {
+      cerr << "Cannot load " << argv[3]
+           << " as a measure of " << permutation.size() << " nodes" << endl;
+      return EXIT_FAILURE;
+    }
+
+    RowVector w;
+    if(!permute(v,permutation,w)) {
+      cerr << "Invalid permutation " << argv[2] << endl;
+      return EXIT_FAILURE;
+    }
+    return w.store(argv[4])?EXIT_SUCCESS:EXIT_FAILURE;
+  }
+
+  if(argc<4 || argc>5)
+    return usage(argv[0]);
+
+  NodeOrdering ordering;
+  const string name=argv[3];
+  if(name=="degree")
+    ordering=ORDER_DEGREE;
+  else if(name=="rcm")
+    ordering=ORDER_RCM;
+  else if(name=="gorder")
+    ordering=ORDER_GORDER;
+  else
+    return usage(argv[0]);
+
+  cerr << "Loading graph..." << endl;
+  PackedGraphOptions mapping;
+  mapping.readOnly=true;
+  const PackedGraph g(argv[1],mapping);
+
+  if(!g.isOk()) {
+    cerr << "Cannot load " << argv[1] << endl;
+    return EXIT_FAILURE;
+  }
+
+  cerr << "Computing ordering..." << endl;
+  vector<node_t> permutation;
+  computeOrdering(g,ordering,permutation);
+
+  if(argc==5 && !storePermutation(permutation,argv[4])) {
+    cerr << "Cannot write " << argv[4] << endl;
+    return EXIT_FAILURE;
+  }
+
+  cerr << "Storing graph..." << endl;
+  g.advise(ACCESS_RANDOM);
+  if(!storePermuted(g,permutation,argv[2])) {
+    cerr << "Cannot build " << argv[2] << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
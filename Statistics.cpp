@@ -36,7 +36,10 @@ int main(int argc, char **argv) {
     return EXIT_FAILURE;
   }
 
-  PackedGraph g(argv[1]);
+  PackedGraphOptions mapping;
+  mapping.readOnly=true;
+  mapping.access=ACCESS_SEQUENTIAL;
+  const PackedGraph g(argv[1],mapping);
   cerr << "Nb of nodes: "<<setw(10)<<g.getNbNodes() << endl;
   cerr << "Nb of edges: "<<setw(10)<<g.getNbEdges() << endl;
   return EXIT_SUCCESS;
@@ -22,185 +22,484 @@
  *  USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
-#include <list>
+#include <random>
 #include <utility>
-#include <set>
 #include <iostream>
 #include <stdexcept>
+#include <atomic>
+#include <algorithm>
 
 #include "SparseArray.h"
 #include "MutableGraph.h"
+#include "PackedGraph.h"
+#include "Tools.h"
 
 #include "ConnectedComponents.h"
 
 using namespace std;
 
-namespace lsg {
-  void stronglyConnectedComponentsFirstDFS(
-      const Graph &g,
-      vector<node_t> &lastIndex)
+namespace {
+  using namespace lsg;
+
+  // Calls f(t,k) for k in [0,n), t being the calling thread; blocks of
+  // indices are distributed dynamically, as the work per index varies
+  template<typename F> void parallelFor(unsigned nbThreads,size_t n,F f)
   {
-    list<pair<node_t,bool> > toBrowse;
+    const size_t block=1024;
+    atomic<size_t> next(0);
+
+    runInParallel(nbThreads,[&](unsigned t) {
+      for(size_t begin;(begin=next.fetch_add(block))<n;) {
+        const size_t end=min(n,begin+block);
+        for(size_t k=begin;k<end;++k)
+          f(t,k);
+      }
+    });
+  }
 
-    node_t size=g.getNbNodes();
-    lastIndex.resize(size);
+  // Removes from active the nodes with a component
+  void compact(vector<node_t> &active,const vector<atomic<node_t> > &label)
+  {
+    active.erase(remove_if(active.begin(),active.end(),[&label](node_t i) {
+        return label[i].load(memory_order_relaxed)!=0;
+      }),active.end());
+  }
 
-    for(node_t k=0;k<size;++k)
-      lastIndex[k]=0;
-    
-    node_t node=0;
+  // Whether i has an edge, in the given direction, to another node
+  // without a component
+  bool hasActiveNeighbor(const Graph &g,bool forward,node_t i,
+                         const vector<atomic<node_t> > &label)
+  {
+    const EdgeSpan<const value_t> e=forward?g.rowEdges(i):g.columnEdges(i);
 
-    node_t currentIndex=0;
-    while(node<size) {
-      toBrowse.push_back(make_pair(node,true));
-      lastIndex[node]=static_cast<node_t>(-1);
+    for(EdgeSpan<const value_t>::iterator it=e.begin(),itend=e.end();
+        it!=itend;
+        ++it)
+      if(it.index()!=i && label[it.index()].load(memory_order_relaxed)==0)
+        return true;
 
-      while(!toBrowse.empty()) {
-        pair<node_t,bool> &item=toBrowse.back();
-        int i=item.first;
+    return false;
+  }
 
-        if(item.second) { // Start
-          item.second=false;
+  // Position in the row of a node, for the depth-first search of
+  // finishingOrder. Spans are kept as long as they remain valid while
+  // other rows are read, that is, unless the graph is compressed;
+  // compressed rows are then decoded on the fly.
+  struct SpanCursor {
+    node_t node;
+    EdgeSpan<const value_t>::iterator it;
+    EdgeSpan<const value_t>::iterator end;
+
+    SpanCursor(node_t i,const EdgeSpan<const value_t> &r) :
+      node(i), it(r.begin()), end(r.end()) {}
+    SpanCursor(const Graph &g,node_t i) : SpanCursor(i,g.rowEdges(i)) {}
+
+    inline bool next(node_t &j)
+    {
+      if(it==end)
+        return false;
+      j=it.index();
+      ++it;
+      return true;
+    }
+  };
 
-          for(SparseArray::const_iterator it=g.row(i).begin(),
-              itend=g.row(i).end();
-              it!=itend;
-              ++it)
-            if(lastIndex[it.index()]==0) {
-              lastIndex[it.index()]=static_cast<node_t>(-1); 
-                                   // Tempory non-0 value
+  struct DecodingCursor {
+    node_t node;
+    node_t left;
+    SparseArray::const_iterator it;
+
+    DecodingCursor(const Graph &g,node_t i) :
+      node(i), left(g.rowSize(i)), it(g.row(i).begin()) {}
+
+    inline bool next(node_t &j)
+    {
+      if(!left)
+        return false;
+      j=it.index();
+      ++it;
+      --left;
+      return true;
+    }
+  };
 
-              toBrowse.push_back(make_pair(it.index(),true));
-            }
-        } else { // End
-          toBrowse.pop_back();
-          lastIndex[i]=++currentIndex;
-        }
-      } 
+  // Nodes by increasing finishing time of a depth-first search along
+  // rows; the stack holds one cursor per node of the current path
+  template<typename Cursor>
+    void finishingOrder(const Graph &g,vector<node_t> &order)
+  {
+    const node_t size=g.getNbNodes();
+
+    vector<char> visited(size);
+    vector<Cursor> stack;
+
+    for(node_t root=0;root<size;++root) {
+      if(visited[root])
+        continue;
+
+      visited[root]=1;
+      stack.emplace_back(g,root);
 
-      for(;node<size && lastIndex[node];++node)
-        ;
+      while(!stack.empty()) {
+        node_t j;
+        if(stack.back().next(j)) {
+          if(!visited[j]) {
+            visited[j]=1;
+            stack.emplace_back(g,j);
+          }
+        } else {
+          order.push_back(stack.back().node);
+          stack.pop_back();
+        }
+      }
     }
   }
+}
 
-  struct OrderBySecondDec {
-    int operator()(const pair<node_t,node_t> &a,
-                  const pair<node_t,node_t> &b) const {
-      return a.second>b.second;
-    }
-  };
-  
-  void stronglyConnectedComponentsSecondDFS(
-      const Graph &g,
-      const vector<node_t> &lastIndex,
-      vector<node_t> &comp)
+namespace lsg {
+  void stronglyConnectedComponents(const Graph &g,vector<node_t> &comp)
   {
-    list<node_t> toBrowse;
-    
-    set<pair<node_t,node_t>,OrderBySecondDec> orderedVertices;
-    
-    node_t size=g.getNbNodes();
+    const node_t size=g.getNbNodes();
 
-    for(node_t k=0;k<size;++k)
-      orderedVertices.insert(make_pair(k,lastIndex[k]));
+    comp.assign(size,0);
 
+    // First pass: nodes by increasing finishing time
+    vector<node_t> order;
+    order.reserve(size);
+
+    const PackedGraph *pg=dynamic_cast<const PackedGraph *>(&g);
+    if(pg && pg->isCompressed())
+      finishingOrder<DecodingCursor>(g,order);
+    else
+      finishingOrder<SpanCursor>(g,order);
+
+    // Second pass: search along columns, by decreasing finishing time
+    vector<node_t> stack;
     node_t currentCompIndex=0;
-    
-    for(set<pair<node_t,node_t>,OrderBySecondDec>::const_iterator
-          it=orderedVertices.begin(),itend=orderedVertices.end();
-        it!=itend;
-        ++it) {
-      node_t node=it->first;
-      
-      if(comp[node])
+
+    for(node_t k=size;k-->0;) {
+      const node_t root=order[k];
+
+      if(comp[root])
         continue;
-      
-      toBrowse.push_back(node);
-      comp[node]=++currentCompIndex;
 
-      while(!toBrowse.empty()) {
-        int i=toBrowse.back();
-        toBrowse.pop_back();
+      comp[root]=++currentCompIndex;
+      stack.push_back(root);
 
-        for(SparseArray::const_iterator it=g.column(i).begin(),
-            itend=g.column(i).end();
+      while(!stack.empty()) {
+        const node_t i=stack.back();
+        stack.pop_back();
+
+        const EdgeSpan<const value_t> c=g.columnEdges(i);
+
+        for(EdgeSpan<const value_t>::iterator it=c.begin(),itend=c.end();
             it!=itend;
             ++it)
           if(comp[it.index()]==0) {
             comp[it.index()]=currentCompIndex;
-            toBrowse.push_back(it.index());
+            stack.push_back(it.index());
           }
-      } 
+      }
     }
   }
 
-  void stronglyConnectedComponents(const Graph &g,vector<node_t> &comp)
+  void parallelStronglyConnectedComponents(const Graph &g,
+                                           vector<node_t> &comp,
+                                           unsigned nbThreads)
   {
-    node_t size=g.getNbNodes();
+    const node_t size=g.getNbNodes();
 
-    comp.resize(size);
+    if(!nbThreads)
+      nbThreads=getNbThreads();
 
+    // Components are first identified by one of their nodes plus one; 0
+    // stands for nodes whose component is not known yet
+    vector<atomic<node_t> > label(size);
     for(node_t i=0;i<size;++i)
-      comp[i]=0;
+      label[i].store(0,memory_order_relaxed);
 
-    vector<node_t> lastIndex;
-    stronglyConnectedComponentsFirstDFS(g,lastIndex);
+    vector<node_t> active(size);
+    for(node_t i=0;i<size;++i)
+      active[i]=i;
+
+    // Trimming: a node without successor or without predecessor among
+    // active nodes is a component on its own
+    const unsigned MAX_TRIM_PASSES=3;
+    for(unsigned pass=0;pass<MAX_TRIM_PASSES && !active.empty();++pass) {
+      atomic<size_t> trimmed(0);
+
+      parallelFor(nbThreads,active.size(),[&](unsigned,size_t k) {
+        const node_t i=active[k];
+        if(!hasActiveNeighbor(g,true,i,label) ||
+           !hasActiveNeighbor(g,false,i,label)) {
+          label[i].store(i+1,memory_order_relaxed);
+          trimmed.fetch_add(1,memory_order_relaxed);
+        }
+      });
 
-    stronglyConnectedComponentsSecondDFS(g,lastIndex,comp);
-  }
+      compact(active,label);
 
-  void weaklyConnectedComponentsBrowse(
-      const Graph &g,
-      vector<node_t> &components,
-      node_t node,
-      node_t nb)
-  {
-    list<node_t> toBrowse;
+      if(!trimmed)
+        break;
+    }
 
-    components[node]=nb;
-    toBrowse.push_back(node);
+    // Forward-backward search from the pivot with the largest product of
+    // degrees, which usually lies in the giant component: this component
+    // is the set of nodes reachable both from and to the pivot
+    if(!active.empty()) {
+      node_t pivot=active[0];
+      edge_t best=0;
+      for(node_t k=0;k<active.size();++k) {
+        const node_t i=active[k];
+        const edge_t d=static_cast<edge_t>(g.rowSize(i))*g.columnSize(i);
+        if(d>best) {
+          best=d;
+          pivot=i;
+        }
+      }
 
-    while(!toBrowse.empty()) {
-      node_t i=toBrowse.front();
-      toBrowse.pop_front();
+      vector<atomic<unsigned char> > mark(size);
+      for(node_t i=0;i<size;++i)
+        mark[i].store(0,memory_order_relaxed);
+
+      // Level-synchronous search; the backward one is restricted to
+      // nodes reached by the forward one
+      for(unsigned char bit=1;bit<=2;bit<<=1) {
+        vector<node_t> frontier(1,pivot);
+        mark[pivot].fetch_or(bit);
+
+        while(!frontier.empty()) {
+          vector<vector<node_t> > next(nbThreads);
+
+          parallelFor(nbThreads,frontier.size(),[&](unsigned t,size_t k) {
+            const node_t i=frontier[k];
+            const EdgeSpan<const value_t> e=
+              bit==1?g.rowEdges(i):g.columnEdges(i);
+
+            for(EdgeSpan<const value_t>::iterator it=e.begin(),
+                itend=e.end();
+                it!=itend;
+                ++it) {
+              const node_t j=it.index();
+              const unsigned char m=mark[j].load(memory_order_relaxed);
+
+              if(!(m&bit) && (bit==1 || (m&1)) &&
+                 label[j].load(memory_order_relaxed)==0 &&
+                 !(mark[j].fetch_or(bit)&bit))
+                next[t].push_back(j);
+            }
+          });
 
-      for(SparseArray::const_iterator it=g.row(i).begin(),
-          itend=g.row(i).end();
-          it!=itend;
-          ++it) {
-        if(components[it.index()]==0) {
-          components[it.index()]=nb;
-          toBrowse.push_back(it.index());
+          frontier.clear();
+          for(unsigned t=0;t<nbThreads;++t)
+            frontier.insert(frontier.end(),next[t].begin(),next[t].end());
         }
       }
+
+      parallelFor(nbThreads,active.size(),[&](unsigned,size_t k) {
+        const node_t i=active[k];
+        if(mark[i].load(memory_order_relaxed)==3)
+          label[i].store(pivot+1,memory_order_relaxed);
+      });
+
+      compact(active,label);
+    }
+
+    // Coloring: the largest node number reaching each node is propagated
+    // along rows; the nodes of color c reaching node c form its component
+    vector<atomic<node_t> > color(size);
+
+    while(!active.empty()) {
+      for(node_t k=0;k<active.size();++k)
+        color[active[k]].store(active[k],memory_order_relaxed);
+
+      for(bool changed=true;changed;) {
+        atomic<bool> modified(false);
+
+        parallelFor(nbThreads,active.size(),[&](unsigned,size_t k) {
+          const node_t i=active[k];
+          const node_t c=color[i].load(memory_order_relaxed);
+          const EdgeSpan<const value_t> r=g.rowEdges(i);
+
+          for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+              it!=itend;
+              ++it) {
+            const node_t j=it.index();
+            if(label[j].load(memory_order_relaxed))
+              continue;
+
+            node_t cj=color[j].load(memory_order_relaxed);
+            while(cj<c && !color[j].compare_exchange_weak(cj,c))
+              ;
+            if(cj<c)
+              modified.store(true,memory_order_relaxed);
+          }
+        });
+
+        changed=modified;
+      }
+
+      vector<node_t> roots;
+      for(node_t k=0;k<active.size();++k)
+        if(color[active[k]].load(memory_order_relaxed)==active[k])
+          roots.push_back(active[k]);
+
+      // Colors are disjoint: each search only sees its own nodes
+      vector<vector<node_t> > stacks(nbThreads);
+      parallelFor(nbThreads,roots.size(),[&](unsigned t,size_t k) {
+        const node_t root=roots[k];
+        vector<node_t> &stack=stacks[t];
+
+        label[root].store(root+1,memory_order_relaxed);
+        stack.push_back(root);
+
+        while(!stack.empty()) {
+          const node_t i=stack.back();
+          stack.pop_back();
+
+          const EdgeSpan<const value_t> c=g.columnEdges(i);
+
+          for(EdgeSpan<const value_t>::iterator it=c.begin(),itend=c.end();
+              it!=itend;
+              ++it) {
+            const node_t j=it.index();
+            if(color[j].load(memory_order_relaxed)==root &&
+               label[j].load(memory_order_relaxed)==0) {
+              label[j].store(root+1,memory_order_relaxed);
+              stack.push_back(j);
+            }
+          }
+        }
+      });
+
+      compact(active,label);
+    }
+
+    // Components are numbered by order of their smallest node
+    comp.assign(size,0);
+    vector<node_t> number(size,0);
+    node_t currentCompIndex=0;
+    for(node_t i=0;i<size;++i) {
+      node_t &n=number[label[i].load(memory_order_relaxed)-1];
+      if(!n)
+        n=++currentCompIndex;
+      comp[i]=n;
     }
   }
 
-  void weaklyConnectedComponents(const Graph &g,vector<node_t> &comp)
+  void weaklyConnectedComponents(const Graph &g,vector<node_t> &comp,
+                                 unsigned nbThreads)
   {
-    node_t size=g.getNbNodes();
-    MutableGraph h=g;
-    h.transpose();
-    h|=g;
+    const node_t size=g.getNbNodes();
 
-    comp.resize(size);
+    if(!nbThreads)
+      nbThreads=getNbThreads();
+
+    // Concurrent union-find (Afforest): trees are only linked from their
+    // larger root to a smaller node
+    vector<atomic<node_t> > parent(size);
+    for(node_t i=0;i<size;++i)
+      parent[i].store(i,memory_order_relaxed);
 
-    fill(comp.begin(),comp.end(),0);
+    auto link=[&parent](node_t u,node_t v) {
+      node_t p1=parent[u].load(memory_order_relaxed);
+      node_t p2=parent[v].load(memory_order_relaxed);
 
-    node_t pos=0;
-    for(int nb=1;;++nb) {
-      weaklyConnectedComponentsBrowse(h,comp,pos,nb);
+      while(p1!=p2) {
+        const node_t high=max(p1,p2),low=min(p1,p2);
+        node_t pHigh=parent[high].load(memory_order_relaxed);
 
-      node_t k;
-      for(k=pos+1;k<size;++k) {
-        if(comp[k]==0) {
-          pos=k;
+        if(pHigh==low)
           break;
+        if(pHigh==high &&
+           parent[high].compare_exchange_strong(pHigh,low))
+          break;
+
+        p1=parent[parent[high].load(memory_order_relaxed)]
+          .load(memory_order_relaxed);
+        p2=parent[low].load(memory_order_relaxed);
+      }
+    };
+
+    auto compress=[&]() {
+      parallelFor(nbThreads,size,[&parent](unsigned,size_t i) {
+        node_t p=parent[i].load(memory_order_relaxed);
+        for(node_t q;(q=parent[p].load(memory_order_relaxed))!=p;p=q)
+          ;
+        parent[i].store(p,memory_order_relaxed);
+      });
+    };
+
+    // Sampling: the first few out-neighbors of every node are linked,
+    // which usually reveals the giant component
+    const unsigned NEIGHBOR_ROUNDS=2;
+
+    for(unsigned r=0;r<NEIGHBOR_ROUNDS;++r) {
+      parallelFor(nbThreads,size,[&](unsigned,size_t i) {
+        const EdgeSpan<const value_t> e=g.rowEdges(i);
+        if(e.size()<=r)
+          return;
+
+        EdgeSpan<const value_t>::iterator it=e.begin();
+        for(unsigned k=0;k<r;++k)
+          ++it;
+        link(i,it.index());
+      });
+
+      compress();
+    }
+
+    // Most frequent root among a sample of nodes
+    node_t giant=0;
+    if(size) {
+      const unsigned NB_SAMPLES=1024;
+      vector<node_t> samples(NB_SAMPLES);
+      mt19937 generator(0);
+      uniform_int_distribution<node_t> distribution(0,size-1);
+      for(unsigned k=0;k<NB_SAMPLES;++k)
+        samples[k]=parent[distribution(generator)].load(memory_order_relaxed);
+
+      sort(samples.begin(),samples.end());
+      for(unsigned k=0,best=0;k<NB_SAMPLES;) {
+        unsigned l=k;
+        for(;l<NB_SAMPLES && samples[l]==samples[k];++l)
+          ;
+        if(l-k>best) {
+          best=l-k;
+          giant=samples[k];
         }
+        k=l;
       }
+    }
 
-      if(k>=size)
-        break;
+    // Remaining edges, except those whose both ends are already in the
+    // giant component: edges from nodes outside it along rows, and
+    // edges to nodes outside it along columns
+    parallelFor(nbThreads,size,[&](unsigned,size_t i) {
+      if(parent[i].load(memory_order_relaxed)==giant)
+        return;
+
+      const EdgeSpan<const value_t> r=g.rowEdges(i);
+      EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+      for(unsigned k=0;k<NEIGHBOR_ROUNDS && it!=itend;++k)
+        ++it;
+      for(;it!=itend;++it)
+        link(i,it.index());
+
+      const EdgeSpan<const value_t> c=g.columnEdges(i);
+      for(it=c.begin(),itend=c.end();it!=itend;++it)
+        link(i,it.index());
+    });
+
+    compress();
+
+    // Components are numbered by order of their smallest node, which is
+    // their root
+    comp.resize(size);
+    node_t currentCompIndex=0;
+    for(node_t i=0;i<size;++i) {
+      const node_t p=parent[i].load(memory_order_relaxed);
+      comp[i]=p==i?++currentCompIndex:comp[p];
     }
   }
 
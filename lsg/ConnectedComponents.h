@@ -31,8 +31,23 @@
 #include "MutableGraph.h"
 
 namespace lsg {
-  void weaklyConnectedComponents(const Graph &g,std::vector<node_t> &comp);
+  // Components are numbered from 1, by order of their smallest node;
+  // computed with nbThreads threads (see getNbThreads) by a concurrent
+  // union-find over rows and columns
+  void weaklyConnectedComponents(const Graph &g,std::vector<node_t> &comp,
+                                 unsigned nbThreads=0);
+
+  // Components are numbered from 1, in topological order: there is no
+  // edge from a component to a component with a lower number
   void stronglyConnectedComponents(const Graph &g,std::vector<node_t> &comp);
+
+  // Same components, computed with nbThreads threads (see getNbThreads)
+  // by trimming, a forward-backward search for the giant component, and
+  // coloring; components are numbered by order of their smallest node
+  void parallelStronglyConnectedComponents(const Graph &g,
+                                           std::vector<node_t> &comp,
+                                           unsigned nbThreads=0);
+
   void contractedGraph(
       const Graph &g,
       const std::vector<node_t> &components,
@@ -0,0 +1,167 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "EdgeList.h"
+
+using namespace std;
+
+namespace lsg {
+  TextFile::TextFile(const string &filename) :
+    ok(false), data(0), length(0)
+  {
+    int fd=open(filename.c_str(),O_RDONLY);
+    if(fd==-1)
+      return;
+
+    struct stat st;
+    if(fstat(fd,&st)) {
+      close(fd);
+      return;
+    }
+    length=st.st_size;
+
+    if(length>0) {
+      void *region=mmap(0,length,PROT_READ,MAP_PRIVATE,fd,0);
+      close(fd);
+      if(region==MAP_FAILED)
+        return;
+      madvise(region,length,MADV_SEQUENTIAL);
+      data=static_cast<const char *>(region);
+    } else
+      close(fd);
+
+    ok=true;
+  }
+
+  TextFile::~TextFile()
+  {
+    if(data)
+      munmap(const_cast<char *>(data),length);
+  }
+
+  void TextFile::chunk(const char *begin,const char *end,
+                       unsigned t,unsigned nbChunks,
+                       const char *&chunkBegin,const char *&chunkEnd) const
+  {
+    const size_t n=end-begin;
+
+    const char *bounds[2]={begin+n*t/nbChunks,begin+n*(t+1)/nbChunks};
+    for(unsigned k=0;k<2;++k) {
+      const char *&q=bounds[k];
+      if(q!=begin && q!=end && q[-1]!='\n') {
+        const char *nl=static_cast<const char *>(memchr(q,'\n',end-q));
+        q=nl?nl+1:end;
+      }
+    }
+
+    chunkBegin=bounds[0];
+    chunkEnd=bounds[1];
+  }
+
+  EdgeList::EdgeList(const string &filename) :
+    TextFile(filename), size(0), with_values(false), body(0)
+  {
+    if(!ok)
+      return;
+    ok=false;
+
+    const char *p=data,*end=data+length;
+    while(p<end && isspace(static_cast<unsigned char>(*p)))
+      ++p;
+
+    from_chars_result r=from_chars(p,end,size);
+    if(r.ec!=errc())
+      return;
+
+    const char *nl=static_cast<const char *>(memchr(r.ptr,'\n',end-r.ptr));
+    if(!nl)
+      return;
+
+    const char *line=nl+1;
+    nl=static_cast<const char *>(memchr(line,'\n',end-line));
+    body=nl?nl+1:end;
+
+    const char *lineEnd=nl?nl:end;
+    if(lineEnd>line && lineEnd[-1]=='\r')
+      --lineEnd;
+    with_values=(string(line,lineEnd)=="with values");
+
+    ok=true;
+  }
+
+  LabelFile::LabelFile(const string &filename) : TextFile(filename)
+  {
+    if(!ok)
+      return;
+
+    const char *const end=data+length;
+    const unsigned nbThreads=getNbThreads();
+    vector<size_t> counts(nbThreads+1);
+
+    // Lines starting in each chunk are counted, then indexed
+    runInParallel(nbThreads,[&](unsigned t) {
+      const char *begin,*chunkEnd;
+      chunk(data,end,t,nbThreads,begin,chunkEnd);
+      for(const char *p=begin;p<chunkEnd;++counts[t+1]) {
+        const char *nl=static_cast<const char *>(memchr(p,'\n',chunkEnd-p));
+        p=nl?nl+1:chunkEnd;
+      }
+    });
+
+    for(unsigned t=0;t<nbThreads;++t)
+      counts[t+1]+=counts[t];
+    starts.resize(counts[nbThreads]);
+
+    runInParallel(nbThreads,[&](unsigned t) {
+      const char *begin,*chunkEnd;
+      chunk(data,end,t,nbThreads,begin,chunkEnd);
+      size_t k=counts[t];
+      for(const char *p=begin;p<chunkEnd;++k) {
+        starts[k]=p;
+        const char *nl=static_cast<const char *>(memchr(p,'\n',chunkEnd-p));
+        p=nl?nl+1:chunkEnd;
+      }
+    });
+  }
+
+  string LabelFile::getLabel(node_t i) const
+  {
+    const char *const end=data+length;
+    const char *p=starts[i];
+    const char *nl=static_cast<const char *>(memchr(p,'\n',end-p));
+    const char *q=nl?nl:end;
+
+    while(q>p && (q[-1]=='\r' || q[-1]=='\n'))
+      --q;
+
+    return string(p,q);
+  }
+}
@@ -0,0 +1,171 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef EDGE_LIST_H
+#define EDGE_LIST_H
+
+#include <string>
+#include <vector>
+#include <charconv>
+#include <cctype>
+
+#include "lsg.h"
+
+#include "Tools.h"
+#include "Uncopyable.h"
+
+namespace lsg {
+  // Memory mapped text file, split into chunks of whole lines
+  class TextFile : private Uncopyable {
+   public:
+    explicit TextFile(const std::string &filename);
+    ~TextFile();
+
+    inline bool isOk() const { return ok; }
+
+   protected:
+    bool ok;
+    const char *data;
+    size_t length;
+
+    // Chunk t of nbChunks of [begin,end), made of the lines starting in
+    // it
+    void chunk(const char *begin,const char *end,
+               unsigned t,unsigned nbChunks,
+               const char *&chunkBegin,const char *&chunkEnd) const;
+  };
+
+  // Edge list in the format of BuildGraphFromEdgeList (see README),
+  // parsed in parallel with std::from_chars
+  class EdgeList : public TextFile {
+   public:
+    explicit EdgeList(const std::string &filename);
+
+    inline node_t getNbNodes() const { return size; }
+    inline bool hasValues() const { return with_values; }
+
+    // Calls f(t,i,j,v) for each edge (i,j) of value v, where t is the
+    // thread parsing the edge; threads parse contiguous chunks of lines.
+    // Returns false on a syntax error.
+    template<typename F> bool parse(F f,unsigned nbThreads=getNbThreads())
+      const;
+
+   private:
+    node_t size;
+    bool with_values;
+    const char *body;
+
+    template<typename F> bool parseLines(const char *p,const char *end,
+                                         F f) const;
+  };
+
+  // File of labels, one per line, indexed in parallel
+  class LabelFile : public TextFile {
+   public:
+    explicit LabelFile(const std::string &filename);
+
+    inline node_t getNbLabels() const { return starts.size(); }
+
+    // Label of the i-th line, without end of line characters
+    std::string getLabel(node_t i) const;
+
+   private:
+    std::vector<const char *> starts;
+  };
+
+  template<typename F> bool EdgeList::parse(F f,unsigned nbThreads) const
+  {
+    if(!ok)
+      return false;
+
+    std::vector<char> success(nbThreads,1);
+
+    runInParallel(nbThreads,[&](unsigned t) {
+      const char *begin,*end;
+      chunk(body,data+length,t,nbThreads,begin,end);
+      success[t]=parseLines(begin,end,[&f,t](node_t i,node_t j,value_t v) {
+        f(t,i,j,v);
+      });
+    });
+
+    for(unsigned t=0;t<nbThreads;++t)
+      if(!success[t])
+        return false;
+
+    return true;
+  }
+
+  template<typename F> bool EdgeList::parseLines(const char *p,
+                                                 const char *end,
+                                                 F f) const
+  {
+    while(p<end) {
+      while(p<end && isspace(static_cast<unsigned char>(*p)))
+        ++p;
+      if(p==end)
+        break;
+
+      node_t i;
+      std::from_chars_result r=std::from_chars(p,end,i);
+      if(r.ec!=std::errc())
+        return false;
+      p=r.ptr;
+
+      for(;;) {
+        while(p<end && (*p==' ' || *p=='\t' || *p=='\r'))
+          ++p;
+        if(p==end || *p=='\n')
+          break;
+
+        node_t j;
+        r=std::from_chars(p,end,j);
+        if(r.ec!=std::errc())
+          return false;
+        p=r.ptr;
+
+        value_t v=1.;
+        if(with_values) {
+          while(p<end && (*p==' ' || *p=='\t'))
+            ++p;
+          if(p==end || *p!=',')
+            return false;
+          ++p;
+          while(p<end && (*p==' ' || *p=='\t'))
+            ++p;
+
+          std::from_chars_result rv=std::from_chars(p,end,v);
+          if(rv.ec!=std::errc())
+            return false;
+          p=rv.ptr;
+        }
+
+        f(i,j,v);
+      }
+    }
+
+    return true;
+  }
+}
+
+#endif /* EDGE_LIST_H */
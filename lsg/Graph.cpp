@@ -23,20 +23,57 @@
  */
 
 #include <ios>
+#include <ostream>
 #include <stdexcept>
 #include <cstdio>
 #include <map>
 #include <cassert>
 #include <algorithm>
+#include <mutex>
 
 #include "unistd.h"
 
 #include "MutableGraph.h"
+#include "GraphWriter.h"
+#include "StreamVByte.h"
 #include "Tools.h"
 
 using namespace std;
 
+namespace {
+  using namespace lsg;
+
+  // Partitions computed by balancedPartition
+  struct CachedPartition {
+    const Graph *graph;
+    bool byColumns;
+    node_t nbNodes;
+    edge_t nbEdges;
+    vector<node_t> bounds;
+  };
+
+  mutex partitionsMutex;
+  vector<CachedPartition> partitions;
+}
+
 namespace lsg {
+  Graph::~Graph()
+  {
+    forgetPartitions();
+  }
+
+  void Graph::forgetPartitions() const
+  {
+    lock_guard<mutex> lock(partitionsMutex);
+
+    for(unsigned k=0;k<partitions.size();)
+      if(partitions[k].graph==this) {
+        partitions[k]=partitions.back();
+        partitions.pop_back();
+      } else
+        ++k;
+  }
+
   ostream &operator<<(ostream &out,const Graph &g)
   {
     const node_t size=g.getNbNodes();
@@ -100,229 +137,170 @@ namespace lsg {
     return true;
   }
 
-  FILE *Graph::beginStore(const string &filename, node_t size) const
+  void balancedPartition(const Graph &g,bool byColumns,unsigned nbParts,
+                         vector<node_t> &bounds)
   {
-    FILE *f=fopen(filename.c_str(),"w");
-    if(ftruncate(fileno(f),0))
-      return 0;
-    fseek(f,0,SEEK_SET);
-    
-    if(!f)
-      return 0;
-    
-    fwrite("GPH",1,3,f);
-
-    unsigned char charmagic=
-      MAGIC_WITH_TRANSPOSE |
-      (hasValues()?MAGIC_WITH_VALUES:0) |
-      (hasLabels()?MAGIC_WITH_LABELS:0);
+    const node_t size=g.getNbNodes();
 
-    fwrite(&charmagic,1,1,f);
+    if(nbParts<=1) {
+      bounds.assign(1,0);
+      bounds.push_back(size);
+      return;
+    }
 
-    seekTillAlign(f,sizeof(node_t));
-    fwrite(&size,sizeof(node_t),1,f);
+    const edge_t nbEdges=g.getNbEdges();
+    {
+      lock_guard<mutex> lock(partitionsMutex);
+      for(unsigned k=0;k<partitions.size();++k) {
+        const CachedPartition &p=partitions[k];
+        if(p.graph==&g && p.byColumns==byColumns &&
+           p.bounds.size()==nbParts+1) {
+          if(p.nbNodes==size && p.nbEdges==nbEdges) {
+            bounds=p.bounds;
+            return;
+          }
+          partitions[k]=partitions.back();
+          partitions.pop_back();
+          break;
+        }
+      }
+    }
 
-    node_t nbEdges=getNbEdges();
-    fwrite(&nbEdges,sizeof(node_t),1,f);
+    unsigned long total=0;
+    for(node_t i=0;i<size;++i)
+      total+=1+(byColumns?g.columnSize(i):g.rowSize(i));
 
-    unsigned long offsetr=0,offsetc=0,offsetl=0;
+    bounds.resize(nbParts+1);
+    bounds[0]=0;
 
-    bool with_values=hasValues();
+    unsigned long work=0;
+    node_t i=0;
+    for(unsigned k=1;k<nbParts;++k) {
+      const unsigned long target=total*k/nbParts;
 
-    for(node_t i=0;i<size;++i) {
-      fwrite(&offsetr,sizeof(unsigned long),1,f);
-      offsetr+=1+row(i).size()*(with_values?2:1);
-    }  
+      for(;i<size && work<target;++i)
+        work+=1+(byColumns?g.columnSize(i):g.rowSize(i));
 
-    for(node_t i=0;i<size;++i) {
-      fwrite(&offsetc,sizeof(unsigned long),1,f);
-      offsetc+=1+column(i).size()*(with_values?2:1);
+      bounds[k]=i;
     }
 
-    if(hasLabels()) {
-      for(node_t i=0;i<size;++i) {
-        fwrite(&offsetl,sizeof(unsigned long),1,f);
-        offsetl+=1+getLabelSize(i);
-      }
-    }
+    bounds[nbParts]=size;
 
-    return f;
+    const CachedPartition p={&g,byColumns,size,nbEdges,bounds};
+    lock_guard<mutex> lock(partitionsMutex);
+    partitions.push_back(p);
   }
 
-  struct CompareByFirst :
-    std::binary_function<
-    const pair<node_t,node_t> &,
-    const pair<node_t,node_t> &,
-    bool>
-  {
-    inline bool operator()(
-        const pair<node_t,node_t> &lhs,
-        const pair<node_t,node_t> &rhs)
-    {
-      return lhs.first<rhs.first;
-    }
-  };
-
-  bool Graph::storeSubgraph(const std::string &filename,
-                            const std::vector<bool> &nodes) const
+  bool Graph::store(const string &filename) const
   {
     if(!hasValues())
       throw std::logic_error("Not implemented.");
 
-    node_t newSize=count(nodes.begin(),nodes.end(),true);
-
-    FILE *f=beginStore(filename,newSize);
-    // The number of edges, offsets are
-    // incorrect, this will be fixed at the end of this function
-
-    if(!f)
-      return false;
-
-    std::vector<node_t> rowSize(newSize);
-    std::vector<node_t> columnSize(newSize);
-
-    node_t oldSize=getNbNodes();
-  
-    vector<node_t> reindex(oldSize);
-    node_t k=0;
-    
-    for(node_t i=0;i<oldSize;++i)
-      if(nodes[i])
-        reindex[i]=k++;
-
-    node_t nbEdges=0;
-
-    vector<vector<pair<node_t,node_t> > > edges(newSize);
-
-    for(node_t i=0;i<oldSize;++i) {
-      if(!nodes[i])
-        continue;
+    const node_t size=getNbNodes();
 
-      const node_t reindex_i=reindex[i];
-      const auto start=ftell(f);
+    vector<node_t> columnSizes(size);
+    for(node_t j=0;j<size;++j)
+      columnSizes[j]=columnSize(j);
 
-      fseek(f,sizeof(node_t),SEEK_CUR); // We'll change this at the end
-                                         // of the loop
+    GraphWriter w(filename,columnSizes,hasLabels());
 
-      node_t nb=0;
+    for(node_t i=0;i<size;++i) {
+      const EdgeSpan<const value_t> r=rowEdges(i);
 
-      for(SparseArray::const_iterator it=row(i).begin(),
-                                   itend=row(i).end();
+      for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
           it!=itend;
-          ++it) {
-        if(nodes[it.index()]) {
-          const node_t j=reindex[it.index()];
-
-          edges[reindex_i].push_back(make_pair(j,nbEdges));
+          ++it)
+        w.add(i,it.index(),*it);
+    }
 
-          fwrite(&j,sizeof(node_t),1,f);
-          fwrite(&nbEdges,sizeof(node_t),1,f);
+    if(hasLabels())
+      for(node_t i=0;i<size;++i)
+        w.addLabel(getLabel(i));
 
-          ++nb,++nbEdges;
-        }
-      }
+    return w.close();
+  }
 
-      sort(edges[reindex_i].begin(),edges[reindex_i].end(),CompareByFirst());
+  bool Graph::storeSubgraph(const std::string &filename,
+                            const std::vector<bool> &nodes) const
+  {
+    if(!hasValues())
+      throw std::logic_error("Not implemented.");
 
-      const auto end=ftell(f);
-      fseek(f,start,SEEK_SET);
-      fwrite(&nb,sizeof(node_t),1,f);
-      fseek(f,end,SEEK_SET);
+    const node_t oldSize=getNbNodes();
+    const node_t newSize=count(nodes.begin(),nodes.end(),true);
 
-      rowSize[reindex[i]]=nb;
-    }
+    vector<node_t> reindex(oldSize);
+    vector<node_t> columnSizes(newSize);
 
-    for(node_t i=0;i<oldSize;++i) {
-      if(!nodes[i])
+    for(node_t j=0,k=0;j<oldSize;++j) {
+      if(!nodes[j])
         continue;
 
-      const node_t reindex_i=reindex[i];
-      const auto start=ftell(f);
-
-      fseek(f,sizeof(node_t),SEEK_CUR); // We'll change this at the end
-                                         // of the loop
+      const EdgeSpan<const value_t> c=columnEdges(j);
 
-      node_t nb=0;
-      
-      for(SparseArray::const_iterator it=column(i).begin(),
-                                   itend=column(i).end();
+      for(EdgeSpan<const value_t>::iterator it=c.begin(),itend=c.end();
           it!=itend;
-          ++it) {
-        if(nodes[it.index()]) {
-          const node_t j=reindex[it.index()];
-          
-          const node_t valueIndex=
-            lower_bound(edges[j].begin(),edges[j].end(),
-                        make_pair(reindex_i,0),
-                        CompareByFirst())->second;
-          
-          fwrite(&j,sizeof(node_t),1,f);
-          fwrite(&valueIndex,sizeof(node_t),1,f);
-
-          ++nb;
-        }
-      }
-      
-      const auto end=ftell(f);
-      fseek(f,start,SEEK_SET);
-      fwrite(&nb,sizeof(node_t),1,f);
-      fseek(f,end,SEEK_SET);
+          ++it)
+        if(nodes[it.index()])
+          ++columnSizes[k];
 
-      columnSize[reindex[i]]=nb;
+      reindex[j]=k++;
     }
 
-    // We can free up the space used by edges now !
-    edges.clear();
-
-    seekTillAlign(f,sizeof(value_t));
+    GraphWriter w(filename,columnSizes,hasLabels());
 
     for(node_t i=0;i<oldSize;++i) {
       if(!nodes[i])
         continue;
 
-      for(SparseArray::const_iterator it=row(i).begin(),
-                                   itend=row(i).end();
+      const EdgeSpan<const value_t> r=rowEdges(i);
+
+      for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
           it!=itend;
           ++it)
         if(nodes[it.index()])
-          fwrite(&*it,sizeof(value_t),1,f);
+          w.add(reindex[i],reindex[it.index()],*it);
     }
-    
+
     if(hasLabels())
-      for(node_t i=0;i<oldSize;++i) {
+      for(node_t i=0;i<oldSize;++i)
         if(nodes[i])
-          fwrite(getLabel(i).c_str(),1,getLabelSize(i)+1,f);
-      }
+          w.addLabel(getLabel(i));
 
-    // Let's now write the proper values for edges and offsets
-    fseek(f,4,SEEK_SET);
-    seekTillAlign(f,sizeof(node_t)); 
-    fseek(f,sizeof(node_t),SEEK_CUR);
-    
-    fwrite(&nbEdges,sizeof(node_t),1,f);
-    
-    unsigned long offsetr=0,offsetc=0,offsetl=0;
+    return w.close();
+  }
 
-    bool with_values=true;
+  namespace {
+    // Calls f(j,v) for the edges of row i of g and (with a null value)
+    // for the edges of column i not in row i, and returns their number
+    template<typename F> node_t forEachSymmetrizedEdge(const Graph &g,
+                                                       node_t i,F f)
+    {
+      const EdgeSpan<const value_t> r=g.rowEdges(i),c=g.columnEdges(i);
 
-    for(node_t i=0;i<newSize;++i) {
-      fwrite(&offsetr,sizeof(unsigned long),1,f);
-      offsetr+=1+rowSize[i]*(with_values?2:1);
-    }  
+      EdgeSpan<const value_t>::iterator
+        itr=r.begin(),
+        itendr=r.end(),
+        itc=c.begin(),
+        itendc=c.end();
 
-    for(node_t i=0;i<newSize;++i) {
-      fwrite(&offsetc,sizeof(unsigned long),1,f);
-      offsetc+=1+columnSize[i]*(with_values?2:1);
-    }
-    
-    if(hasLabels())
-      for(node_t i=0;i<oldSize;++i)
-        if(nodes[i]) {
-          fwrite(&offsetl,sizeof(unsigned long),1,f);
-          offsetl+=1+getLabelSize(i);
+      node_t nb=0;
+
+      for(;itr!=itendr || itc!=itendc;++nb) {
+        if(itc==itendc || (itr!=itendr && itr.index()<itc.index())) {
+          f(itr.index(),*itr);
+          ++itr;
+        } else if(itr==itendr || itr.index()>itc.index()) {
+          f(itc.index(),0.);
+          ++itc;
+        } else {
+          f(itr.index(),*itr);
+          ++itr,++itc;
         }
+      }
 
-    return !fclose(f);
+      return nb;
+    }
   }
 
   bool Graph::storeWithTransposedEdges(const string &filename) const
@@ -330,178 +308,136 @@ namespace lsg {
     if(!hasValues())
       throw std::logic_error("Not implemented.");
 
-    node_t size=getNbNodes();
+    // The result is symmetric: columns have the same sizes as rows
+    const node_t size=getNbNodes();
 
-    FILE *f=beginStore(filename,size); 
-    // The number of edges and offsets are incorrect, this will be fixed
-    // at the end of this function
+    vector<node_t> sizes(size);
+    for(node_t i=0;i<size;++i)
+      sizes[i]=forEachSymmetrizedEdge(*this,i,[](node_t,value_t) {});
 
-    if(!f)
-      return false;
-  
-    node_t nbEdges=getNbEdges();
+    GraphWriter w(filename,sizes,hasLabels());
 
-    std::vector<node_t> rowSize(size);
-    std::vector<node_t> columnSize(size);
-    
-    vector<vector<pair<node_t,node_t> > > edges(size);
+    for(node_t i=0;i<size;++i)
+      forEachSymmetrizedEdge(*this,i,
+          [&w,i](node_t j,value_t v) { w.add(i,j,v); });
 
-    for(node_t i=0;i<size;++i) {
-      const auto start=ftell(f);
+    if(hasLabels())
+      for(node_t i=0;i<size;++i)
+        w.addLabel(getLabel(i));
 
-      fseek(f,sizeof(node_t),SEEK_CUR); // We'll change this at the end
-                                         // of the loop
+    return w.close();
+  }
 
-      node_t nb=0;
-      const SparseArray &r=row(i),&c=column(i);
+  bool Graph::storeCompressed(const string &filename) const
+  {
+    if(!hasValues())
+      throw std::logic_error("Not implemented.");
 
-      SparseArray::const_iterator
-        itr=r.begin(),
-        itendr=r.end(),
-        itc=c.begin(),
-        itendc=c.end();
+    if(sizeof(node_t)!=sizeof(uint32_t))
+      throw domain_error("Compressed graphs require 32-bit nodes");
 
-      for(;itr!=itendr || itc!=itendc;) {
-        ++nb;
+    const node_t size=getNbNodes();
+    const edge_t nbEdges=getNbEdges();
 
-        if(itc==itendc || (itr!=itendr && itr.index()<itc.index())) {
-          itr.write(f);
-          ++itr;
-        } else if(itr==itendr || itr.index()>itc.index()) {
-          node_t j=itc.index();
-          fwrite(&j,sizeof(node_t),1,f);
-          fwrite(&nbEdges,sizeof(node_t),1,f);
+    vector<edge_t> firstr(size+1),indexr(size+1),firstc(size+1),
+                   indexc(size+1);
+    vector<unsigned char> rowStream,columnStream;
 
-          edges[i].push_back(make_pair(j,nbEdges));
-          ++nbEdges,++itc;
-        } else {
-          itr.write(f);
-          ++itr,++itc;
-        }
-      }
+    {
+      // Columns are gathered by counting sort, along with the ranks of
+      // their entries in rows
+      vector<uint32_t> indices,sources(nbEdges),ranks(nbEdges);
 
-      sort(edges[i].begin(),edges[i].end(),CompareByFirst());
+      for(node_t j=0;j<size;++j)
+        firstc[j+1]=firstc[j]+columnSize(j);
 
-      const auto end=ftell(f);
-      fseek(f,start,SEEK_SET);
-      fwrite(&nb,sizeof(node_t),1,f);
-      fseek(f,end,SEEK_SET);
+      vector<edge_t> fill(firstc.begin(),firstc.end()-1);
 
-      rowSize[i]=nb;
-    }
+      for(node_t i=0;i<size;++i) {
+        const EdgeSpan<const value_t> r=rowEdges(i);
 
-    for(node_t i=0;i<size;++i) {
-      const auto start=ftell(f);
-      
-      fseek(f,sizeof(node_t),SEEK_CUR); // We'll change this at the end
-                                         // of the loop
-      
-      node_t nb=0;
-      const SparseArray &r=row(i),&c=column(i);
+        indices.clear();
+        for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+            it!=itend;
+            ++it) {
+          const edge_t pos=fill[it.index()]++;
+          sources[pos]=i;
+          ranks[pos]=indices.size();
 
-      SparseArray::const_iterator
-        itr=r.begin(),
-        itendr=r.end(),
-        itc=c.begin(),
-        itendc=c.end();
+          indices.push_back(it.index());
+        }
 
-      for(;itr!=itendr || itc!=itendc;) {
-        ++nb;
+        firstr[i+1]=firstr[i]+indices.size();
+        indexr[i]=rowStream.size();
+        svbEncode(indices.data(),indices.size(),true,rowStream);
+      }
+      indexr[size]=rowStream.size();
 
-        if(itc==itendc || (itr!=itendr && itr.index()<itc.index())) {
-          node_t j=itr.index();
-          fwrite(&j,sizeof(node_t),1,f);
-          
-          const node_t valueIndex=
-            lower_bound(edges[j].begin(),edges[j].end(),
-                        make_pair(i,0),
-                        CompareByFirst())->second;
-          
-          fwrite(&valueIndex,sizeof(node_t),1,f);
+      for(node_t j=0;j<size;++j) {
+        const uint32_t n=firstc[j+1]-firstc[j];
 
-          ++itr;
-        } else if(itr==itendr || itr.index()>itc.index()) {
-          itc.write(f);
-          ++itc;
-        } else {
-          itc.write(f);
-          ++itr,++itc;
-        }
+        indexc[j]=columnStream.size();
+        svbEncode(&sources[0]+firstc[j],n,true,columnStream);
+        svbEncode(&ranks[0]+firstc[j],n,false,columnStream);
       }
-
-      const auto end=ftell(f);
-      fseek(f,start,SEEK_SET);
-      fwrite(&nb,sizeof(node_t),1,f);
-      fseek(f,end,SEEK_SET);
-      
-      columnSize[i]=nb;
+      indexc[size]=columnStream.size();
     }
 
-    seekTillAlign(f,sizeof(value_t));
+    FILE *f=fopen(filename.c_str(),"w");
 
-    writeValues(f);
+    if(!f)
+      return false;
 
-    value_t dummy=0;
+    char header[EXTENDED_HEADER_SIZE];
+    makeExtendedHeader(header,
+                       MAGIC_COMPRESSED | MAGIC_WITH_VALUES |
+                       MAGIC_WITH_TRANSPOSE |
+                       (hasLabels()?
+                        MAGIC_WITH_LABELS|MAGIC_WITH_LABEL_INDEX:0),
+                       size,nbEdges);
+    fwrite(header,1,EXTENDED_HEADER_SIZE,f);
 
-    node_t additional_edges=nbEdges-getNbEdges();
-    for(node_t i=0;i<additional_edges;++i)
-      fwrite(&dummy,sizeof(value_t),1,f);
+    fwrite(&firstr[0],sizeof(edge_t),size+1,f);
+    fwrite(&indexr[0],sizeof(edge_t),size+1,f);
+    fwrite(&firstc[0],sizeof(edge_t),size+1,f);
+    fwrite(&indexc[0],sizeof(edge_t),size+1,f);
 
-    if(hasLabels())
+    if(hasLabels()) {
+      edge_t offsetl=0;
       for(node_t i=0;i<size;++i) {
-        fwrite(getLabel(i).c_str(),1,getLabelSize(i)+1,f);
+        fwrite(&offsetl,sizeof(edge_t),1,f);
+        offsetl+=1+getLabelSize(i);
       }
+    }
 
-    // Let's now write the proper values for edges and offsets
-    fseek(f,4,SEEK_SET);
-    seekTillAlign(f,sizeof(node_t)); 
-    fseek(f,sizeof(node_t),SEEK_CUR);
-    
-    fwrite(&nbEdges,sizeof(node_t),1,f);
-    
-    unsigned long offsetr=0,offsetc=0;
+    rowStream.resize(rowStream.size()+SVB_PADDING);
+    fwrite(&rowStream[0],1,rowStream.size(),f);
+    columnStream.resize(columnStream.size()+SVB_PADDING);
+    fwrite(&columnStream[0],1,columnStream.size(),f);
 
-    bool with_values=true;
+    seekTillAlign(f,sizeof(value_t));
 
     for(node_t i=0;i<size;++i) {
-      fwrite(&offsetr,sizeof(unsigned long),1,f);
-      offsetr+=1+rowSize[i]*(with_values?2:1);
-    }  
+      const EdgeSpan<const value_t> r=rowEdges(i);
 
-    for(node_t i=0;i<size;++i) {
-      fwrite(&offsetc,sizeof(unsigned long),1,f);
-      offsetc+=1+columnSize[i]*(with_values?2:1);
+      for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+          it!=itend;
+          ++it)
+        fwrite(&*it,sizeof(value_t),1,f);
     }
 
-    return !fclose(f);
-  }
-
-  bool Graph::store(const string &filename) const
-  {
-    node_t size=getNbNodes();
-
-    FILE *f=beginStore(filename,size);
-
-    if(!f)
-      return false;
-    
-    for(node_t i=0;i<size;++i)
-      row(i).write(f);
-
-    for(node_t i=0;i<size;++i)
-      column(i).write(f);
-
-    if(hasValues()) {
-      seekTillAlign(f,sizeof(value_t));
-
-      writeValues(f);
-    }
+    if(hasLabels()) {
+      LabelIndex index(size);
 
-    if(hasLabels())
       for(node_t i=0;i<size;++i) {
-        fwrite(getLabel(i).c_str(),1,getLabelSize(i)+1,f);
+        const string label=getLabel(i);
+        fwrite(label.c_str(),1,label.size()+1,f);
+        index.add(label.c_str(),i);
       }
 
+      index.write(f);
+    }
+
     return !fclose(f);
   }
 
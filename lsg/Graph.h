@@ -53,13 +53,13 @@ namespace lsg {
 
    public:
     Graph() : ok(false),destroyed(false) {}
-    virtual ~Graph() {}
+    virtual ~Graph();
 
     inline bool isOk() const { return ok; }
     virtual bool hasValues() const=0;
     virtual bool hasLabels() const=0;
     virtual node_t getNbNodes() const=0;
-    virtual node_t getNbEdges() const=0;
+    virtual edge_t getNbEdges() const=0;
     value_t operator()(node_t i,node_t j) const;
     inline Proxy operator()(node_t i,node_t j) { return Proxy(*this,i,j); }
 
@@ -68,17 +68,31 @@ namespace lsg {
     virtual const SparseArray &row(node_t i) const=0;
     virtual const SparseArray &column(node_t j) const=0;
 
+    // Allocation-free access to rows and columns, see EdgeSpan
+    virtual EdgeSpan<value_t> rowEdges(node_t i)=0;
+    virtual EdgeSpan<value_t> columnEdges(node_t j)=0;
+    virtual EdgeSpan<const value_t> rowEdges(node_t i) const=0;
+    virtual EdgeSpan<const value_t> columnEdges(node_t j) const=0;
+
+    // Sizes of rows and columns, without going through their entries
+    inline virtual node_t rowSize(node_t i) const { return row(i).size(); }
+    inline virtual node_t columnSize(node_t j) const
+      { return column(j).size(); }
+
     virtual std::string getLabel(node_t i) const=0;
     virtual node_t getNodeWithLabel(const std::string &s) const=0;
     virtual std::string::size_type getLabelSize(node_t i) const=0;
 
-    inline node_t outDegree(node_t i) const { return row(i).size(); }
-    inline node_t inDegree(node_t j) const { return column(j).size(); }
+    inline node_t outDegree(node_t i) const { return rowSize(i); }
+    inline node_t inDegree(node_t j) const { return columnSize(j); }
 
+    // Graphs are stored in the CSR format (see MAGIC_CSR)
     bool store(const std::string &filename) const;
     bool storeWithTransposedEdges(const std::string &filename) const;
     bool storeSubgraph(const std::string &filename,
                        const std::vector<bool> &vec) const;
+    // Stores the graph in the compressed format (see MAGIC_COMPRESSED)
+    bool storeCompressed(const std::string &filename) const;
 
     virtual void transpose()=0;
 
@@ -91,23 +105,82 @@ namespace lsg {
     
   private:
     bool ok;
-    virtual void writeValues(FILE *f) const=0;
     virtual value_t &insert_new_edge(node_t i,node_t j)=0;
-    FILE *beginStore(const std::string &filename,node_t size) const;
 
   protected:
     inline void setOk() { ok=true; }
+    // To be called when rows and columns are exchanged, see
+    // balancedPartition
+    void forgetPartitions() const;
     bool destroyed;
   };
 
+  // Splits the nodes of g into nbParts consecutive ranges
+  // [bounds[k],bounds[k+1]) of roughly equal work, the work for a node
+  // being 1 plus the size of its row (or column, if byColumns).
+  // Partitions are cached with the graph, until its number of nodes or
+  // edges changes or it is transposed; any partition remains valid, a
+  // stale one being only less balanced.
+  void balancedPartition(const Graph &g,bool byColumns,unsigned nbParts,
+                         std::vector<node_t> &bounds);
+
   std::ostream &operator<<(std::ostream &os,const Graph &g);
   bool operator==(const Graph &g, const Graph &h);
   inline bool operator!=(const Graph &g, const Graph &h) { return !(g==h); }
 
+  // GPH files start with "GPH" and a byte of flags. In the plain
+  // format, the number of nodes and of edges follow as 32-bit integers,
+  // then the offsets of rows, of columns and of labels (as unsigned
+  // longs), then rows and columns (as a size followed by (index, value
+  // index) pairs of 32-bit integers), values and labels. Plain files can
+  // be read, but are no longer written.
   const unsigned char MAGIC_WITH_VALUES   =0x01;
   const unsigned char MAGIC_WITH_TRANSPOSE=0x02;
   const unsigned char MAGIC_WITH_LABELS   =0x04;
   const unsigned char MAGIC_IS_TRANSPOSED =0x08;
+  const unsigned char MAGIC_WITH_LABEL_INDEX=0x10;
+
+  // Rows and columns are stored as Stream VByte encoded gaps between
+  // consecutive indices (see StreamVByte.h), values being stored in row
+  // order, so that row value indices are implicit; column value indices
+  // are encoded, after the column indices, as the ranks of the entries in
+  // their rows. The header is followed by, as edge_t, the prefix sums of
+  // row sizes and the byte offsets of rows in the row stream (size+1
+  // entries each), the same for columns, and the label offsets; then the
+  // row and column streams, each followed by SVB_PADDING bytes; values
+  // and labels are as in the CSR format. Requires 32-bit nodes.
+  const unsigned char MAGIC_COMPRESSED    =0x20;
+
+  // Struct-of-arrays layout: the header is followed by, as edge_t, the
+  // prefix sums of row sizes and of column sizes (size+1 entries each)
+  // and the label offsets; then the indices of all rows, the indices of
+  // all columns, and, aligned, the value indices (as edge_t) of all
+  // columns; values are stored in row order, so that row value indices
+  // are implicit. Then come, aligned, values, labels and the label index.
+  // Without MAGIC_WITH_TRANSPOSE, column sizes, indices and value indices
+  // are left out, and only rows can be read.
+  const unsigned char MAGIC_CSR           =0x40;
+
+  // Extended header, required by the compressed and CSR formats: after
+  // the flags byte, padding up to 8 bytes, then, as 64-bit integers,
+  // extended flags, the number of nodes and the number of edges
+  const unsigned char MAGIC_EXTENDED      =0x80;
+
+  // Extended flags: nodes are 64-bit (see LSG_WIDE_NODES in lsg.h)
+  const std::uint64_t EXTENDED_WIDE_NODES =0x01;
+  // Extended flags: values are floats (see LSG_FLOAT_VALUES in lsg.h)
+  const std::uint64_t EXTENDED_FLOAT_VALUES=0x02;
+
+  // Value files (GPV files, ending in .gpv) hold another value array
+  // for the graph of a GPH file, so that variants of a graph (e.g.,
+  // normalized, reversed) share a single copy of its structure. They
+  // start with "GPV" and a byte of flags (only MAGIC_IS_TRANSPOSED), then
+  // the fields of an extended header, the length of the path of the
+  // graph file as a 64-bit integer, and the path (relative to the
+  // directory of the value file, unless absolute); then come, aligned,
+  // the values, in the order of the value array of the graph file.
+  // Opening a value file as a PackedGraph opens its graph file
+  // read-only, with these values.
 }
 
 #endif /* GRAPH_H */
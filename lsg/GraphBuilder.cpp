@@ -0,0 +1,365 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <queue>
+
+#include "GraphBuilder.h"
+#include "GraphWriter.h"
+
+using namespace std;
+using namespace lsg;
+
+namespace {
+  // Maximal number of runs merged at once; above it, runs are first
+  // merged into longer runs
+  const size_t MAX_FAN_IN=128;
+  const size_t MIN_READ_BUFFER=1<<16;
+
+  struct HeapEntry {
+    GraphBuilder::Edge e;
+    size_t run;
+  };
+
+  // Equal edges come out in run order, that is, in the order in which
+  // they were added
+  struct Later {
+    inline bool operator()(const HeapEntry &a,const HeapEntry &b) const
+      { return b.e<a.e || (!(a.e<b.e) && b.run<a.run); }
+  };
+
+  // Sorts edges, keeping the first of equal ones
+  void sortEdges(vector<GraphBuilder::Edge> &edges)
+  {
+    stable_sort(edges.begin(),edges.end());
+    edges.erase(unique(edges.begin(),edges.end(),
+                       [](const GraphBuilder::Edge &a,
+                          const GraphBuilder::Edge &b) {
+                         return !(a<b);
+                       }),
+                edges.end());
+  }
+
+  // Calls f on the edges of the runs, in order, skipping all but the
+  // first of equal edges; stops and returns false as soon as f does, or
+  // if a run cannot be read
+  template<typename F> bool mergeRuns(
+      vector<TempFile *>::const_iterator begin,
+      vector<TempFile *>::const_iterator end,
+      size_t bufferSize, F f)
+  {
+    vector<FILE *> files;
+    priority_queue<HeapEntry,vector<HeapEntry>,Later> heap;
+    bool ok=true;
+
+    for(vector<TempFile *>::const_iterator it=begin;it!=end;++it) {
+      FILE *file=fopen((*it)->name().c_str(),"rb");
+      if(!file) {
+        ok=false;
+        break;
+      }
+      setvbuf(file,0,_IOFBF,bufferSize);
+      files.push_back(file);
+
+      HeapEntry h;
+      h.run=files.size()-1;
+      if(fread(&h.e,sizeof(h.e),1,file)==1)
+        heap.push(h);
+    }
+
+    GraphBuilder::Edge previous;
+    bool empty=true;
+    while(ok && !heap.empty()) {
+      HeapEntry h=heap.top();
+      heap.pop();
+
+      if(empty || previous<h.e) {
+        if(!f(h.e)) {
+          ok=false;
+          break;
+        }
+        previous=h.e;
+        empty=false;
+      }
+
+      if(fread(&h.e,sizeof(h.e),1,files[h.run])==1)
+        heap.push(h);
+    }
+
+    for(size_t k=0;k<files.size();++k) {
+      if(ferror(files[k]))
+        ok=false;
+      fclose(files[k]);
+    }
+
+    return ok;
+  }
+}
+
+namespace lsg {
+  GraphBuilder::GraphBuilder(const string &f,node_t s,size_t m,bool t) :
+    ok(true), closed(false), filename(f), size(s), memory(m),
+    with_transpose(t),
+    columnSizes(s), labelFile(0), labels(0), nbLabels(0)
+  {
+    buffer.reserve(max<size_t>(1,memory/sizeof(Edge)));
+  }
+
+  GraphBuilder::~GraphBuilder()
+  {
+    close();
+  }
+
+  void GraphBuilder::add(node_t i,node_t j,value_t v)
+  {
+    if(!ok || closed || i>=size || j>=size) {
+      ok=false;
+      return;
+    }
+
+    Edge e;
+    e.i=i;
+    e.j=j;
+    e.v=v;
+    buffer.push_back(e);
+
+    if(buffer.size()==buffer.capacity())
+      spill(buffer);
+  }
+
+  GraphBuilder::Inserter::Inserter(GraphBuilder &b,unsigned nbInserters) :
+    builder(b), ok(true)
+  {
+    buffer.reserve(max<size_t>(1,b.memory/nbInserters/sizeof(Edge)));
+  }
+
+  GraphBuilder::Inserter::~Inserter()
+  {
+    if(!buffer.empty())
+      builder.spill(buffer);
+
+    if(!ok) {
+      lock_guard<std::mutex> lock(builder.mutex);
+      builder.ok=false;
+    }
+  }
+
+  void GraphBuilder::Inserter::add(node_t i,node_t j,value_t v)
+  {
+    if(i>=builder.size || j>=builder.size) {
+      ok=false;
+      return;
+    }
+
+    Edge e;
+    e.i=i;
+    e.j=j;
+    e.v=v;
+    buffer.push_back(e);
+
+    if(buffer.size()==buffer.capacity())
+      builder.spill(buffer);
+  }
+
+  void GraphBuilder::addLabel(const string &label)
+  {
+    if(!ok || closed || nbLabels==size) {
+      ok=false;
+      return;
+    }
+
+    if(!labels) {
+      labelFile=new TempFile();
+      labels=fopen(labelFile->name().c_str(),"w+b");
+      if(!labels) {
+        ok=false;
+        return;
+      }
+    }
+
+    if(fwrite(label.c_str(),1,label.size()+1,labels)!=label.size()+1)
+      ok=false;
+    ++nbLabels;
+  }
+
+  void GraphBuilder::countColumns(const vector<Edge> &edges)
+  {
+    for(size_t k=0;k<edges.size();++k)
+      ++columnSizes[edges[k].j];
+  }
+
+  void GraphBuilder::abort()
+  {
+    lock_guard<std::mutex> lock(mutex);
+    ok=false;
+  }
+
+  void GraphBuilder::spill(vector<Edge> &edges)
+  {
+    {
+      lock_guard<std::mutex> lock(mutex);
+      if(!ok) {
+        edges.clear();
+        return;
+      }
+    }
+
+    sortEdges(edges);
+
+    TempFile *run=new TempFile();
+
+    FILE *f=fopen(run->name().c_str(),"wb");
+    bool written=f &&
+      fwrite(edges.data(),sizeof(Edge),edges.size(),f)==edges.size();
+    if(f && fclose(f))
+      written=false;
+
+    {
+      lock_guard<std::mutex> lock(mutex);
+      runs.push_back(run);
+      countColumns(edges);
+      if(!written)
+        ok=false;
+    }
+
+    edges.clear();
+  }
+
+  bool GraphBuilder::close()
+  {
+    if(closed)
+      return ok;
+    closed=true;
+
+    if(ok && !runs.empty()) {
+      if(!buffer.empty())
+        spill(buffer);
+      vector<Edge>().swap(buffer);
+
+      const size_t bufferSize=
+        max(MIN_READ_BUFFER,memory/min(runs.size(),MAX_FAN_IN));
+
+      // Consecutive groups of runs are merged into longer runs, which
+      // keep the order of the runs, until at most MAX_FAN_IN remain
+      while(ok && runs.size()>MAX_FAN_IN) {
+        vector<TempFile *> merged;
+
+        for(size_t first=0;first<runs.size();first+=MAX_FAN_IN) {
+          const size_t last=min(runs.size(),first+MAX_FAN_IN);
+          if(!ok || last-first==1) {
+            merged.insert(merged.end(),runs.begin()+first,runs.begin()+last);
+            continue;
+          }
+
+          TempFile *run=new TempFile();
+          merged.push_back(run);
+          FILE *out=fopen(run->name().c_str(),"wb");
+          if(!out) {
+            ok=false;
+            merged.insert(merged.end(),runs.begin()+first,runs.begin()+last);
+            continue;
+          }
+          setvbuf(out,0,_IOFBF,bufferSize);
+
+          ok=mergeRuns(runs.begin()+first,runs.begin()+last,bufferSize,
+                       [out](const Edge &e) {
+                         return fwrite(&e,sizeof(e),1,out)==1;
+                       });
+          if(fclose(out))
+            ok=false;
+
+          for(size_t k=first;k<last;++k)
+            delete runs[k];
+        }
+
+        runs.swap(merged);
+      }
+
+      // Column sizes of several runs include edges duplicated across
+      // runs: they are counted again on the merged edges
+      if(ok && runs.size()>1) {
+        fill(columnSizes.begin(),columnSizes.end(),0);
+        ok=mergeRuns(runs.begin(),runs.end(),
+                     max(MIN_READ_BUFFER,memory/runs.size()),
+                     [this](const Edge &e) {
+                       ++columnSizes[e.j];
+                       return true;
+                     });
+      }
+    } else {
+      sortEdges(buffer);
+      countColumns(buffer);
+    }
+
+    if(ok) {
+      GraphWriter w(filename,columnSizes,nbLabels>0,with_transpose);
+
+      auto write=[&w](const Edge &e) {
+        w.add(e.i,e.j,e.v);
+        return true;
+      };
+
+      if(runs.empty())
+        ok=all_of(buffer.begin(),buffer.end(),write);
+      else
+        ok=mergeRuns(runs.begin(),runs.end(),
+                     max(MIN_READ_BUFFER,memory/runs.size()),write);
+
+      if(ok && nbLabels>0) {
+        rewind(labels);
+
+        string label;
+        for(int c=getc(labels);c!=EOF;c=getc(labels)) {
+          if(c)
+            label+=c;
+          else {
+            w.addLabel(label);
+            label.clear();
+          }
+        }
+
+        for(node_t i=nbLabels;i<size;++i)
+          w.addLabel("");
+      }
+
+      if(!w.close())
+        ok=false;
+      if(!ok)
+        remove(filename.c_str());
+    }
+
+    vector<Edge>().swap(buffer);
+    for(size_t k=0;k<runs.size();++k)
+      delete runs[k];
+    runs.clear();
+
+    if(labels)
+      fclose(labels);
+    labels=0;
+    delete labelFile;
+    labelFile=0;
+
+    return ok;
+  }
+}
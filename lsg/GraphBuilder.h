@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GRAPH_BUILDER_H
+#define GRAPH_BUILDER_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <mutex>
+
+#include "lsg.h"
+
+#include "TempFile.h"
+#include "Uncopyable.h"
+
+namespace lsg {
+  // Builds a GPH file from edges given in any order, with bounded
+  // memory: edges are buffered, and sorted runs are spilled to temporary
+  // files whenever the buffer exceeds the memory budget; runs are then
+  // merged directly into a GraphWriter, after a first merge counting
+  // the edges of each column if there are several. Apart from the
+  // buffer, memory usage only depends on the number of nodes. Without
+  // transpose, only rows are stored (see GraphWriter).
+  class GraphBuilder : private Uncopyable {
+   public:
+    GraphBuilder(const std::string &filename,node_t size,
+                 size_t memory=DEFAULT_MEMORY,bool withTranspose=true);
+    ~GraphBuilder();
+
+    inline bool isOk() const { return ok; }
+
+    // An edge added several times keeps its first value
+    void add(node_t i,node_t j,value_t v);
+
+    // Labels are given in node order; the graph has labels as soon as
+    // one is given, missing ones being empty
+    void addLabel(const std::string &label);
+
+    // Merges the runs and writes the graph; returns false if anything
+    // went wrong, in which case no graph file is left
+    bool close();
+
+    // Gives up the graph: nothing more is spilled or written, and
+    // close() returns false
+    void abort();
+
+    static const size_t DEFAULT_MEMORY=1<<28;
+
+    struct Edge {
+      node_t i;
+      node_t j;
+      value_t v;
+
+      inline bool operator<(const Edge &e) const
+        { return i<e.i || (i==e.i && j<e.j); }
+    };
+
+    // Adds edges to a builder concurrently with other inserters (but
+    // not with the add method of the builder), with its own buffer of
+    // 1/nbInserters of the memory budget; remaining edges are spilled
+    // when the inserter is destroyed, which must happen before close().
+    // Among duplicate edges added by different inserters, the one kept
+    // is unspecified
+    class Inserter : private Uncopyable {
+     public:
+      Inserter(GraphBuilder &b,unsigned nbInserters);
+      ~Inserter();
+
+      void add(node_t i,node_t j,value_t v);
+
+     private:
+      GraphBuilder &builder;
+      std::vector<Edge> buffer;
+      bool ok;
+    };
+
+   private:
+    bool ok;
+    bool closed;
+    std::string filename;
+    node_t size;
+    size_t memory;
+    bool with_transpose;
+
+    std::vector<Edge> buffer;
+    std::vector<TempFile *> runs;
+    std::vector<node_t> columnSizes;
+    std::mutex mutex;
+
+    TempFile *labelFile;
+    FILE *labels;
+    node_t nbLabels;
+
+    void spill(std::vector<Edge> &edges);
+    void countColumns(const std::vector<Edge> &edges);
+  };
+}
+
+#endif /* GRAPH_BUILDER_H */
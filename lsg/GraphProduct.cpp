@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "GraphProduct.h"
+#include "Graph.h"
+#include "Vector.h"
+#include "Tools.h"
+
+using namespace std;
+
+namespace {
+  using namespace lsg;
+
+  // Rows are distributed among threads by chunks of this size
+  const node_t CHUNK_SIZE=64;
+
+  inline EdgeSpan<const value_t> edges(const Graph &g,node_t i,
+                                       bool transposed)
+  {
+    return transposed?g.columnEdges(i):g.rowEdges(i);
+  }
+}
+
+namespace lsg {
+  bool storeProduct(const Graph &a,const Graph &b,const string &filename,
+                    const GraphProductOptions &options)
+  {
+    const node_t size=a.getNbNodes();
+    if(b.getNbNodes()!=size)
+      throw invalid_argument("Graphs of different sizes");
+
+    unsigned nbThreads=options.nbThreads?options.nbThreads:getNbThreads();
+    if(nbThreads>size)
+      nbThreads=size?size:1;
+
+    GraphBuilder builder(filename,size,options.memory);
+    if(!builder.isOk())
+      return false;
+
+    atomic<node_t> next(0);
+
+    runInParallel(nbThreads,[&](unsigned) {
+      GraphBuilder::Inserter inserter(builder,nbThreads);
+      FrontierVector row(size);
+      vector<pair<node_t,value_t> > left,entries;
+
+      for(;;) {
+        const node_t begin=next.fetch_add(CHUNK_SIZE);
+        if(begin>=size)
+          break;
+        const node_t end=min<node_t>(size,begin+CHUNK_SIZE);
+
+        for(node_t i=begin;i<end;++i) {
+          row.clear();
+
+          // Spans of compressed graphs share a per-thread buffer, which
+          // the spans of b may reuse: the row of a is copied first
+          const EdgeSpan<const value_t> r=edges(a,i,options.transposeLeft);
+          left.clear();
+          r.forEach([&](node_t k,value_t w) {
+            left.push_back(make_pair(k,options.pattern?1.:w));
+          });
+
+          for(vector<pair<node_t,value_t> >::const_iterator
+                k=left.begin();k!=left.end();++k) {
+            const value_t x=k->second;
+
+            edges(b,k->first,options.transposeRight).forEach(
+              [&](node_t j,value_t w) {
+                row.add(j,options.pattern?x:x*w);
+              });
+          }
+
+          entries.clear();
+          row.forEach([&](node_t j,double v) {
+            if(options.diagonal || j!=i)
+              entries.push_back(make_pair(j,v));
+          });
+
+          if(options.topK && entries.size()>options.topK) {
+            nth_element(entries.begin(),entries.begin()+options.topK,
+                        entries.end(),
+                        [](const pair<node_t,value_t> &x,
+                           const pair<node_t,value_t> &y) {
+                          return x.second>y.second ||
+                            (x.second==y.second && x.first<y.first);
+                        });
+            entries.resize(options.topK);
+          }
+
+          for(vector<pair<node_t,value_t> >::const_iterator
+                it=entries.begin();it!=entries.end();++it)
+            inserter.add(i,it->first,it->second);
+        }
+      }
+    });
+
+    if(a.hasLabels())
+      for(node_t i=0;i<size;++i)
+        builder.addLabel(a.getLabel(i));
+
+    return builder.close();
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GRAPH_PRODUCT_H
+#define GRAPH_PRODUCT_H
+
+#include <string>
+
+#include "lsg.h"
+
+#include "GraphBuilder.h"
+
+namespace lsg {
+  class Graph;
+
+  struct GraphProductOptions {
+    GraphProductOptions() :
+      transposeLeft(false), transposeRight(false), pattern(false),
+      diagonal(true), topK(0), nbThreads(0),
+      memory(GraphBuilder::DEFAULT_MEMORY) {}
+
+    bool transposeLeft;   // multiply by the transpose of a
+    bool transposeRight;  // multiply by the transpose of b
+    bool pattern;         // take all values of a and b as 1
+    bool diagonal;        // keep the entries (i,i)
+    node_t topK;          // if not 0, keep the topK largest entries of
+                          // each row (ties broken by smaller index)
+    unsigned nbThreads;   // getNbThreads() if 0
+    size_t memory;        // budget of the GraphBuilder writing the result
+  };
+
+  // Stores the product of a and b (or of their transposes) as a GPH
+  // file, with the labels of a. Rows are computed in parallel
+  // (Gustavson's algorithm: row i of the product is the sum of the rows
+  // of b given by row i of a, accumulated in a per-thread dense array)
+  // and written through a GraphBuilder, so that memory usage only depends
+  // on the number of nodes and on the memory budget. For instance,
+  // co-citations are a^T*a and bibliographic couplings a*a^T, with
+  // pattern set. Returns false if the file could not be written; a and b
+  // must have the same number of nodes.
+  bool storeProduct(const Graph &a,const Graph &b,const std::string &filename,
+                    const GraphProductOptions &options=GraphProductOptions());
+}
+
+#endif /* GRAPH_PRODUCT_H */
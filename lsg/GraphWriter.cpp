@@ -0,0 +1,211 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "GraphWriter.h"
+#include "Graph.h"
+
+using namespace std;
+
+namespace {
+  inline size_t align(size_t offset,size_t size)
+  {
+    return (offset+size-1)/size*size;
+  }
+}
+
+namespace lsg {
+  void makeExtendedHeader(char *header,unsigned char magic,
+                          node_t size,edge_t nbEdges)
+  {
+    memset(header,0,EXTENDED_HEADER_SIZE);
+    memcpy(header,"GPH",3);
+    header[3]=magic|MAGIC_EXTENDED;
+
+    const uint64_t fields[3]={
+      (sizeof(node_t)==sizeof(uint64_t)?EXTENDED_WIDE_NODES:0)|
+      (sizeof(value_t)==sizeof(float)?EXTENDED_FLOAT_VALUES:0),
+      size,
+      nbEdges};
+    memcpy(header+8,fields,sizeof(fields));
+  }
+
+  GraphWriter::GraphWriter(const string &filename,
+                           const vector<node_t> &columnSizes,
+                           bool withLabels,bool withTranspose) :
+    ok(false), closed(false), fd(-1), file(0), region(MAP_FAILED),
+    regionSize(0), size(columnSizes.size()), nbEdges(0),
+    with_labels(withLabels), with_transpose(withTranspose), firstc(0),
+    fill(columnSizes.size()), currentRow(0), k(0),
+    labelIndex(withLabels?columnSizes.size():0), nbLabels(0),
+    labelOffset(0)
+  {
+    for(node_t j=0;j<size;++j) {
+      fill[j]=nbEdges;
+      nbEdges+=columnSizes[j];
+    }
+
+    const size_t offsetFirstr=EXTENDED_HEADER_SIZE;
+    const size_t offsetFirstc=offsetFirstr+(size+1)*sizeof(edge_t);
+    const size_t offsetIndexl=
+      offsetFirstc+(with_transpose?size+1:0)*sizeof(edge_t);
+    const size_t offsetRows=offsetIndexl+(with_labels?size:0)*sizeof(edge_t);
+    const size_t offsetColumns=offsetRows+nbEdges*sizeof(node_t);
+    const size_t offsetColumnValueIndices=
+      align(offsetColumns+nbEdges*sizeof(node_t),sizeof(edge_t));
+    const size_t offsetValues=with_transpose?
+      align(offsetColumnValueIndices+nbEdges*sizeof(edge_t),sizeof(value_t)):
+      align(offsetColumns,sizeof(value_t));
+    regionSize=offsetValues+nbEdges*sizeof(value_t);
+
+    fd=open(filename.c_str(),O_RDWR|O_CREAT|O_TRUNC,0666);
+    if(fd==-1)
+      return;
+
+    file=fdopen(fd,"r+");
+    if(!file) {
+      ::close(fd);
+      return;
+    }
+
+    if(ftruncate(fd,regionSize))
+      return;
+
+    region=mmap(0,regionSize,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    if(region==MAP_FAILED)
+      return;
+
+    char *const base=static_cast<char *>(region);
+
+    makeExtendedHeader(base,
+                       MAGIC_CSR | MAGIC_WITH_VALUES |
+                       (with_transpose?MAGIC_WITH_TRANSPOSE:0) |
+                       (with_labels?MAGIC_WITH_LABELS|MAGIC_WITH_LABEL_INDEX:0),
+                       size,nbEdges);
+
+    firstr=reinterpret_cast<edge_t *>(base+offsetFirstr);
+    if(with_transpose)
+      firstc=reinterpret_cast<edge_t *>(base+offsetFirstc);
+    indexl=reinterpret_cast<edge_t *>(base+offsetIndexl);
+    rowIndices=reinterpret_cast<node_t *>(base+offsetRows);
+    columnIndices=reinterpret_cast<node_t *>(base+offsetColumns);
+    columnValueIndices=
+      reinterpret_cast<edge_t *>(base+offsetColumnValueIndices);
+    values=reinterpret_cast<value_t *>(base+offsetValues);
+
+    firstr[0]=0;
+    if(with_transpose) {
+      for(node_t j=0;j<size;++j)
+        firstc[j]=fill[j];
+      firstc[size]=nbEdges;
+    }
+
+    if(fseeko(file,regionSize,SEEK_SET))
+      return;
+
+    ok=true;
+  }
+
+  GraphWriter::~GraphWriter()
+  {
+    close();
+  }
+
+  void GraphWriter::add(node_t i,node_t j,value_t v)
+  {
+    if(!ok || i<currentRow || i>=size || j>=size || k==nbEdges ||
+       (with_transpose && fill[j]==firstc[j+1])) {
+      ok=false;
+      return;
+    }
+
+    for(;currentRow<i;++currentRow)
+      firstr[currentRow+1]=k;
+
+    if(k>firstr[currentRow] && rowIndices[k-1]>=j) {
+      ok=false;
+      return;
+    }
+
+    rowIndices[k]=j;
+    values[k]=v;
+
+    if(with_transpose) {
+      const edge_t pos=fill[j]++;
+      columnIndices[pos]=i;
+      columnValueIndices[pos]=k;
+    }
+
+    ++k;
+  }
+
+  void GraphWriter::addLabel(const string &label)
+  {
+    if(!ok || !with_labels || nbLabels==size) {
+      ok=false;
+      return;
+    }
+
+    indexl[nbLabels]=labelOffset;
+    labelOffset+=label.size()+1;
+
+    if(fwrite(label.c_str(),1,label.size()+1,file)!=label.size()+1)
+      ok=false;
+
+    labelIndex.add(label.c_str(),nbLabels++);
+  }
+
+  bool GraphWriter::close()
+  {
+    if(closed)
+      return ok;
+    closed=true;
+
+    if(ok) {
+      for(;currentRow<size;++currentRow)
+        firstr[currentRow+1]=k;
+
+      if(k!=nbEdges || (with_labels && nbLabels!=size))
+        ok=false;
+    }
+
+    if(ok && with_labels)
+      labelIndex.write(file);
+
+    if(region!=MAP_FAILED)
+      munmap(region,regionSize);
+
+    if(file) {
+      if(fclose(file))
+        ok=false;
+    }
+
+    return ok;
+  }
+}
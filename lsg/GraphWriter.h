@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GRAPH_WRITER_H
+#define GRAPH_WRITER_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "lsg.h"
+
+#include "Tools.h"
+#include "Uncopyable.h"
+
+namespace lsg {
+  // Header of GPH files in the extended format (see MAGIC_EXTENDED)
+  const size_t EXTENDED_HEADER_SIZE=32;
+  void makeExtendedHeader(char *header,unsigned char magic,
+                          node_t size,edge_t nbEdges);
+
+  // Writes a graph in the CSR format (see MAGIC_CSR). The size of each
+  // column must be known in advance; edges are then given row by row,
+  // and stored through a shared mapping of the output file, so that
+  // memory usage only depends on the number of nodes. Without
+  // transpose, only rows are stored, and columns cannot be read.
+  class GraphWriter : private Uncopyable {
+   public:
+    GraphWriter(const std::string &filename,
+                const std::vector<node_t> &columnSizes,
+                bool withLabels,bool withTranspose=true);
+    ~GraphWriter();
+
+    inline bool isOk() const { return ok; }
+
+    // Edges must be added by increasing source, then by strictly
+    // increasing target
+    void add(node_t i,node_t j,value_t v);
+
+    // Labels of all nodes, in order, after all edges
+    void addLabel(const std::string &label);
+
+    // Returns false if anything went wrong, including a number of edges
+    // or labels not matching what was announced
+    bool close();
+
+   private:
+    bool ok;
+    bool closed;
+    int fd;
+    FILE *file;
+    void *region;
+    size_t regionSize;
+
+    node_t size;
+    edge_t nbEdges;
+    bool with_labels;
+    bool with_transpose;
+
+    edge_t *firstr;
+    edge_t *firstc;
+    edge_t *indexl;
+    node_t *rowIndices;
+    node_t *columnIndices;
+    edge_t *columnValueIndices;
+    value_t *values;
+
+    std::vector<edge_t> fill;
+    node_t currentRow;
+    edge_t k;
+
+    LabelIndex labelIndex;
+    node_t nbLabels;
+    edge_t labelOffset;
+  };
+}
+
+#endif /* GRAPH_WRITER_H */
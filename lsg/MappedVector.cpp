@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "MappedVector.h"
+
+using namespace std;
+
+namespace {
+  // Magic number and size, then the values
+  const size_t HEADER_SIZE=4+sizeof(unsigned int);
+
+  // Mappings are page-aligned, so values can be accessed in place
+  static_assert(HEADER_SIZE%sizeof(double)==0,
+                "MSR values must be aligned");
+}
+
+namespace lsg {
+  MappedVector::MappedVector() :
+    ok(false), region(MAP_FAILED), regionSize(0), values(0), n(0)
+  {
+  }
+
+  MappedVector::MappedVector(const string &filename) :
+    ok(false), region(MAP_FAILED), regionSize(0), values(0), n(0)
+  {
+    int fd=open(filename.c_str(),O_RDONLY);
+    if(fd<0)
+      return;
+
+    struct stat st;
+    if(fstat(fd,&st) || static_cast<size_t>(st.st_size)<HEADER_SIZE) {
+      ::close(fd);
+      return;
+    }
+
+    regionSize=st.st_size;
+    region=mmap(0,regionSize,PROT_READ,MAP_SHARED,fd,0);
+    ::close(fd);
+    if(region==MAP_FAILED)
+      return;
+
+    char *base=static_cast<char *>(region);
+    if(strncmp(base,"MSR0",4))
+      return;
+    memcpy(&n,base+4,sizeof(unsigned int));
+    if(regionSize!=HEADER_SIZE+static_cast<size_t>(n)*sizeof(double))
+      return;
+
+    values=reinterpret_cast<double *>(base+HEADER_SIZE);
+    ok=true;
+  }
+
+  MappedVector::~MappedVector()
+  {
+    unmap();
+  }
+
+  void MappedVector::unmap()
+  {
+    if(region!=MAP_FAILED)
+      munmap(region,regionSize);
+    region=MAP_FAILED;
+    values=0;
+  }
+
+  WritableMappedVector::WritableMappedVector(const string &filename,
+                                             unsigned int size)
+  {
+    int fd=open(filename.c_str(),O_RDWR|O_CREAT|O_TRUNC,0666);
+    if(fd<0)
+      return;
+
+    regionSize=HEADER_SIZE+static_cast<size_t>(size)*sizeof(double);
+    if(ftruncate(fd,regionSize)) {
+      ::close(fd);
+      return;
+    }
+
+    region=mmap(0,regionSize,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    ::close(fd);
+    if(region==MAP_FAILED)
+      return;
+
+    char *base=static_cast<char *>(region);
+    memcpy(base,"MSR0",4);
+    memcpy(base+4,&size,sizeof(unsigned int));
+
+    // The file is zero-filled by ftruncate
+    n=size;
+    values=reinterpret_cast<double *>(base+HEADER_SIZE);
+    ok=true;
+  }
+
+  WritableMappedVector::~WritableMappedVector()
+  {
+    close();
+  }
+
+  bool WritableMappedVector::close()
+  {
+    if(region==MAP_FAILED)
+      return false;
+
+    bool synced=!msync(region,regionSize,MS_SYNC);
+    unmap();
+    ok=false;
+    return synced;
+  }
+}
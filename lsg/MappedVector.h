@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MAPPEDVECTOR_H
+#define MAPPEDVECTOR_H
+
+#include <string>
+
+#include "Uncopyable.h"
+
+namespace lsg {
+  // Vector stored in the binary format of Vector::store, accessed in
+  // place through a read-only memory mapping: opening is immediate,
+  // whatever the size, and pages are shared by all processes using the
+  // file
+  class MappedVector : private Uncopyable
+  {
+  public:
+    MappedVector(const std::string &filename);
+    virtual ~MappedVector();
+
+    bool isOk() const { return ok; }
+    unsigned int size() const { return n; }
+    double operator[](unsigned int i) const { return values[i]; }
+
+  protected:
+    MappedVector();
+    void unmap();
+
+    bool ok;
+    void *region;
+    size_t regionSize;
+    double *values;
+    unsigned int n;
+  };
+
+  // Vector of a given size, created in the format of Vector::store and
+  // written in place; the file is complete once closed
+  class WritableMappedVector : public MappedVector
+  {
+  public:
+    WritableMappedVector(const std::string &filename,unsigned int size);
+    ~WritableMappedVector();
+
+    using MappedVector::operator[];
+    double &operator[](unsigned int i) { return values[i]; }
+
+    bool close();
+  };
+}
+
+#endif /* MAPPEDVECTOR_H */
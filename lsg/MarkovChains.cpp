@@ -25,11 +25,17 @@
 #include <numeric>
 #include <algorithm>
 #include <iostream>
+#include <vector>
+#include <cmath>
+#include <unordered_map>
+#include <deque>
 
 #include "Graph.h"
 #include "MutableGraph.h"
 #include "SparseArray.h"
 #include "Vector.h"
+#include "MarkovChains.h"
+#include "NodeArray.h"
 #include "lsg.h"
 
 using namespace std;
@@ -37,27 +43,334 @@ using namespace std;
 namespace {
   using namespace lsg;
 
-  class DivideBy {
-   public:
-    DivideBy(value_t v) : d(v) { }
-    inline void operator()(value_t &v) { v/=d; }
-
-   private:
-    value_t d;
-  };
-
-	value_t sqr(value_t x)
+	double sqr(double x)
 	{
 		return x*x;
 	}
 
-	value_t l2dist(const RowVector& m1,const RowVector&m2,const RowVector&basem)
+	double l2dist(const RowVector& m1,const RowVector&m2,const RowVector&basem)
 	{
 		node_t size=m1.size();
-		value_t s=0;
+		double s=0;
 		for(node_t i=0;i<size;++i)s+=sqr(m1[i]-m2[i])/basem[i];
 		return sqrt(s);
 	}
+
+  double dot(const Vector &a,const Vector &b)
+  {
+    double s=0.;
+    for(node_t i=0,size=a.size();i<size;++i)
+      s+=a[i]*b[i];
+    return s;
+  }
+
+  double norm(const Vector &a)
+  {
+    return sqrt(dot(a,a));
+  }
+
+  // Relative residual |w-v|/|v| of v, w being v*g
+  double residual(const Vector &v,const Vector &w)
+  {
+    double s=0.;
+    for(node_t i=0,size=v.size();i<size;++i)
+      s+=sqr(w[i]-v[i]);
+    return sqrt(s)/norm(v);
+  }
+
+  // Products by g and bookkeeping shared by the invariant measure solvers
+  class MeasureSolverState {
+   public:
+    MeasureSolverState(const Graph &graph,
+                       const InvariantMeasureOptions &o,
+                       InvariantMeasureReport &r) :
+      g(graph), options(o), report(r) {}
+
+    // w=v*g
+    void product(const RowVector &v,RowVector &w)
+    {
+      multiply(v,g,w,options.kernel);
+      ++report.products;
+    }
+
+    // w=v-v*g, the operator of the Krylov solvers
+    void apply(const RowVector &v,RowVector &w)
+    {
+      product(v,w);
+      for(node_t i=0,size=v.size();i<size;++i)
+        w[i]=v[i]-w[i];
+    }
+
+    void step()
+    {
+      ++report.iterations;
+    }
+
+    // Residual of the current iterate, computed from a product; returns
+    // whether the solver should stop
+    bool check(double r)
+    {
+      if(report.residuals.size()>report.iterations)
+        report.residuals.back()=r;
+      else
+        report.residuals.push_back(r);
+      report.converged=r<=options.tolerance;
+      print(r);
+      return report.converged || report.iterations>=options.maxIterations;
+    }
+
+    // Residual of the current iterate as estimated by the solver; the
+    // solver should then check it if this returns true
+    bool estimate(double r)
+    {
+      report.residuals.push_back(r);
+      print(r);
+      return r<=options.tolerance ||
+             report.iterations>=options.maxIterations;
+    }
+
+    const InvariantMeasureOptions &getOptions() const { return options; }
+    unsigned getIterations() const { return report.iterations; }
+
+   private:
+    void print(double r) const
+    {
+      if(options.verbose)
+        cerr << "Itération " << report.iterations << " : résidu " << r
+             << endl;
+    }
+
+    const Graph &g;
+    const InvariantMeasureOptions &options;
+    InvariantMeasureReport &report;
+  };
+
+  // Quadratic extrapolation from four successive iterates x[0..3]
+  // (Kamvar et al., Extrapolation methods for accelerating PageRank
+  // computations); returns false if they are degenerate
+  bool quadraticExtrapolation(const vector<RowVector> &x,RowVector &v)
+  {
+    const node_t size=v.size();
+    double a=0.,b=0.,c=0.,d=0.,e=0.;
+    for(node_t i=0;i<size;++i) {
+      const double y1=x[1][i]-x[0][i],y2=x[2][i]-x[0][i],y3=x[3][i]-x[0][i];
+      a+=y1*y1;
+      b+=y1*y2;
+      c+=y2*y2;
+      d+=y1*y3;
+      e+=y2*y3;
+    }
+
+    // Least squares solution of gamma1*y1+gamma2*y2=-y3
+    const double det=a*c-b*b;
+    if(!(det>1e-12*a*c))
+      return false;
+    const double gamma1=(b*e-c*d)/det,gamma2=(b*d-a*e)/det;
+
+    const double beta0=gamma1+gamma2+1.,beta1=gamma2+1.;
+    for(node_t i=0;i<size;++i)
+      v[i]=beta0*x[1][i]+beta1*x[2][i]+x[3][i];
+    return true;
+  }
+
+  // Componentwise Aitken extrapolation from three successive iterates;
+  // coordinates which would not remain positive are kept
+  void aitkenExtrapolation(const vector<RowVector> &x,RowVector &v)
+  {
+    for(node_t i=0,size=v.size();i<size;++i) {
+      const double h=x[2][i]-2*x[1][i]+x[0][i];
+      if(h) {
+        const double y=x[2][i]-sqr(x[2][i]-x[1][i])/h;
+        if(y>0)
+          v[i]=y;
+      }
+    }
+  }
+
+  // Extrapolations are given up as soon as one of them does not reduce
+  // the residual, the iterate being then restored
+  void powerSolver(MeasureSolverState &state,RowVector &v)
+  {
+    const InvariantMeasureOptions &options=state.getOptions();
+    unsigned nbIterates=options.solver==SOLVER_QUADRATIC?4:
+                        options.solver==SOLVER_AITKEN?3:0;
+
+    vector<RowVector> iterates;
+    RowVector w,saved;
+    double lastResidual=0.;
+    bool extrapolated=false;
+
+    for(;;) {
+      state.product(v,w);
+      const double r=residual(v,w);
+      if(state.check(r))
+        return;
+
+      if(extrapolated && r>=lastResidual) {
+        v.swap(saved);
+        nbIterates=0;
+        extrapolated=false;
+        continue;
+      }
+      extrapolated=false;
+      lastResidual=r;
+
+      v.swap(w);
+      state.step();
+
+      if(!nbIterates)
+        continue;
+
+      if(iterates.size()==nbIterates)
+        iterates.erase(iterates.begin());
+      iterates.push_back(v);
+
+      if(iterates.size()==nbIterates && options.extrapolationPeriod &&
+         state.getIterations()%options.extrapolationPeriod==0) {
+        saved=v;
+        extrapolated=true;
+        if(nbIterates==4)
+          quadraticExtrapolation(iterates,v);
+        else
+          aitkenExtrapolation(iterates,v);
+        v/=v.sum();
+        iterates.clear();
+      }
+    }
+  }
+
+  // Restarted GMRES on x(I-g)=0: corrections lie in the range of I-g,
+  // whose vectors sum to 0, so that the sum of x is kept
+  void gmresSolver(MeasureSolverState &state,RowVector &x)
+  {
+    const unsigned m=max(state.getOptions().restart,1u);
+
+    vector<RowVector> V(m+1);
+    vector<vector<double> > H(m+1,vector<double>(m));
+    vector<double> cs(m),sn(m),e(m+1),y(m);
+    RowVector w;
+
+    for(;;) {
+      state.product(x,w);
+      w-=x;
+      const double beta=norm(w),xnorm=norm(x);
+      const unsigned before=state.getIterations();
+      if(state.check(beta/xnorm))
+        return;
+
+      V[0]=w;
+      V[0]/=beta;
+      fill(e.begin(),e.end(),0.);
+      e[0]=beta;
+
+      unsigned j=0;
+      while(j<m) {
+        state.apply(V[j],w);
+
+        // Modified Gram-Schmidt
+        for(unsigned i=0;i<=j;++i) {
+          H[i][j]=dot(w,V[i]);
+          for(node_t k=0,size=w.size();k<size;++k)
+            w[k]-=H[i][j]*V[i][k];
+        }
+        const double h=norm(w);
+
+        for(unsigned i=0;i<j;++i) {
+          const double t=cs[i]*H[i][j]+sn[i]*H[i+1][j];
+          H[i+1][j]=-sn[i]*H[i][j]+cs[i]*H[i+1][j];
+          H[i][j]=t;
+        }
+        const double r=sqrt(sqr(H[j][j])+sqr(h));
+        cs[j]=H[j][j]/r;
+        sn[j]=h/r;
+        H[j][j]=r;
+        e[j+1]=-sn[j]*e[j];
+        e[j]*=cs[j];
+
+        ++j;
+        state.step();
+        if(state.estimate(std::abs(e[j])/xnorm) || h<=1e-14*beta)
+          break;
+
+        V[j]=w;
+        V[j]/=h;
+      }
+
+      for(unsigned i=j;i-->0;) {
+        double s=e[i];
+        for(unsigned k=i+1;k<j;++k)
+          s-=H[i][k]*y[k];
+        y[i]=s/H[i][i];
+      }
+      for(unsigned i=0;i<j;++i)
+        for(node_t k=0,size=x.size();k<size;++k)
+          x[k]+=y[i]*V[i][k];
+
+      if(state.getIterations()==before)
+        return;
+    }
+  }
+
+  // BiCGStab on x(I-g)=0, restarted from the true residual whenever it
+  // breaks down or its recursive residual converges
+  void bicgstabSolver(MeasureSolverState &state,RowVector &x)
+  {
+    const node_t size=x.size();
+    RowVector r,rhat,p(size),v(size),t;
+
+    for(;;) {
+      state.product(x,r);
+      r-=x;
+      const double xnorm=norm(x);
+      const unsigned before=state.getIterations();
+      if(state.check(norm(r)/xnorm))
+        return;
+
+      rhat=r;
+      static_cast<valarray<double> &>(p)=0.;
+      static_cast<valarray<double> &>(v)=0.;
+      double rho=1.,alpha=1.,omega=1.;
+
+      for(;;) {
+        const double rhoNew=dot(rhat,r);
+        if(!rhoNew)
+          break;
+        const double beta=rhoNew/rho*alpha/omega;
+        rho=rhoNew;
+        for(node_t i=0;i<size;++i)
+          p[i]=r[i]+beta*(p[i]-omega*v[i]);
+
+        state.apply(p,v);
+        const double d=dot(rhat,v);
+        if(!d)
+          break;
+        alpha=rho/d;
+        for(node_t i=0;i<size;++i)
+          r[i]-=alpha*v[i];
+
+        state.apply(r,t);
+        double tt=0.,tr=0.;
+        for(node_t i=0;i<size;++i) {
+          tt+=t[i]*t[i];
+          tr+=t[i]*r[i];
+        }
+        omega=tt?tr/tt:0.;
+        double rr=0.;
+        for(node_t i=0;i<size;++i) {
+          x[i]+=alpha*p[i]+omega*r[i];
+          r[i]-=omega*t[i];
+          rr+=r[i]*r[i];
+        }
+
+        state.step();
+        if(state.estimate(sqrt(rr)/xnorm) || !omega)
+          break;
+      }
+
+      if(state.getIterations()==before)
+        return;
+    }
+  }
 }
 
 namespace lsg {
@@ -65,9 +378,19 @@ namespace lsg {
   {
     node_t n=g.getNbNodes();
     for(node_t i=0;i<n;++i) {
-      value_t s=accumulate(g.row(i).begin(),g.row(i).end(),0.);
+      const EdgeSpan<value_t> r=g.rowEdges(i);
+
+      double s=0.;
+      for(EdgeSpan<value_t>::iterator it=r.begin(),itend=r.end();
+          it!=itend;
+          ++it)
+        s+=*it;
+
       if(s)
-        for_each(g.row(i).begin(),g.row(i).end(),DivideBy(s));
+        for(EdgeSpan<value_t>::iterator it=r.begin(),itend=r.end();
+            it!=itend;
+            ++it)
+          *it/=s;
     }
   }
   
@@ -75,14 +398,24 @@ namespace lsg {
   {
     node_t n=g.getNbNodes();
     for(node_t i=0;i<n;++i) {
-      value_t s=accumulate(g.column(i).begin(),g.column(i).end(),0.);
+      const EdgeSpan<value_t> c=g.columnEdges(i);
+
+      double s=0.;
+      for(EdgeSpan<value_t>::iterator it=c.begin(),itend=c.end();
+          it!=itend;
+          ++it)
+        s+=*it;
+
       if(s)
-        for_each(g.column(i).begin(),g.column(i).end(),DivideBy(s));
+        for(EdgeSpan<value_t>::iterator it=c.begin(),itend=c.end();
+            it!=itend;
+            ++it)
+          *it/=s;
     }
   }
 
   void InvariantMeasure(const Graph &g, RowVector &v, unsigned niter,
-                        bool verbose)
+                        bool verbose, SpMVKernel kernel)
   {
     RowVector w(g.getNbNodes());
 
@@ -91,7 +424,7 @@ namespace lsg {
         cerr << "Itération " << i << endl;
 
       w=v;
-      v=v*g;
+      multiply(w,g,v,kernel);
       
       if(verbose) {
         cerr << "Somme des éléments de v : " << v.sum() << endl;
@@ -105,107 +438,216 @@ namespace lsg {
     }
   }
 
-  void anotherInvariantMeasure(const Graph &g, RowVector &v, unsigned niter,
-                        bool verbose)
-  {
-		unsigned int size=g.getNbNodes();
-    RowVector vo(v),voo(v),w(v),wo(v);
-		RowVector a1(size),a2(size);
-		value_t s1,s2,c;
-		a1=v*g;
-    for(unsigned n=0;n<(niter+2)/3;++n) {
-      if(verbose)cerr << "Itération " << 3*n << endl;
-			voo=a1;
-			vo=voo*g;
-			if(verbose){
-        cerr << "Norme différence v : " << abs(vo-voo).sum() << endl;
-        cerr << "Dist différence v : " << l2dist(voo,vo,vo) << endl;
-				cerr << "Max différence v : " << abs(vo-voo).max() << endl;
-        cerr << "Max : " << vo.max() << endl;
-        cerr << "Min : " << vo.min() << endl;
-				cerr<<endl;
-				cerr << "Itération " << 3*n+1 << endl;
-			}
-      v=vo*g;
-        cerr << "Norme différence v : " << abs(v-vo).sum() << endl;
-        cerr << "Dist différence v : " << l2dist(vo,v,v) << endl;
-        cerr << "Max différence v : " << abs(v-vo).max() << endl;
-        cerr << "Max : " << v.max() << endl;
-        cerr << "Min : " << v.min() << endl;
-				cerr<<endl;
-			for(node_t i=0;i<size;i++){
-				a1[i]=vo[i]-voo[i];a2[i]=v[i]+voo[i]-2*vo[i];
-			}
-			s1=s2=c=0;
-			for(node_t i=0;i<size;i++){
-				s1+=a1[i]*a1[i]/v[i];s2+=a2[i]*a2[i]/v[i];
-				c+=a1[i]*a2[i]/v[i];
-			}
-			s1=c/s2;
-			for(node_t i=0;i<size;i++){
-				w[i]=voo[i]-s1*a1[i];
-			}
-      
-      if(verbose) {
-        cerr << "Somme des éléments de w : " << w.sum() << endl;
-        cerr << "Itération " << 3*n+2 << endl;
-			a1=w*g;
-        cerr << "Norme différence w : " << abs(w-a1).sum() << endl;
-        cerr << "Dist différence w : " << l2dist(w,a1,v) << endl;
-        cerr << "Max différence w : " << abs(w-a1).max() << endl;
-        cerr << "Max : " << w.max() << endl;
-        cerr << "Min : " << w.min() << endl;
-				if(l2dist(w,a1,v)>l2dist(vo,v,v)){a1=v;cerr<<"Keep v"<<endl;}
+  InvariantMeasureReport InvariantMeasure(const Graph &g, RowVector &v,
+      const InvariantMeasureOptions &options)
+  {
+    const node_t size=g.getNbNodes();
+
+    if(v.size()!=size) {
+      v.resize(size);
+      static_cast<valarray<double> &>(v)=1./size;
+    } else
+      v/=v.sum();
+
+    InvariantMeasureReport report;
+    MeasureSolverState state(g,options,report);
+
+    switch(options.solver) {
+      case SOLVER_GMRES:
+        gmresSolver(state,v);
+        break;
+      case SOLVER_BICGSTAB:
+        bicgstabSolver(state,v);
+        break;
+      default:
+        powerSolver(state,v);
+    }
+
+    v/=v.sum();
+    return report;
+  }
+
+  unsigned PageRank(const Graph &g, RowVector &v,
+                    const PageRankOptions &options)
+  {
+    const node_t size=g.getNbNodes();
+    const double d=options.damping;
+
+    if(v.size()!=size) {
+      v.resize(size);
+      for(node_t i=0;i<size;++i)
+        v[i]=1./size;
+    }
+
+    vector<bool> dangling(size);
+    double danglingMass=0.;
+
+    for(node_t i=0;i<size;++i) {
+      const EdgeSpan<const value_t> r=g.rowEdges(i);
+
+      double s=0.;
+      r.forEach([&s](node_t,value_t w) { s+=w; });
+
+      if(s==0.) {
+        dangling[i]=true;
+        danglingMass+=v[i];
+      }
+    }
+
+    unsigned iteration=0;
+
+    if(options.powerIterations) {
+      RowVector w;
+
+      while(iteration<options.maxIterations) {
+        ++iteration;
+
+        multiply(v,g,w,options.kernel);
+
+        double diffNorm=0.,maxDiff=0.,maxRelativeDiff=0.,newDanglingMass=0.;
+        for(node_t j=0;j<size;++j) {
+          const double x=d*(w[j]+danglingMass/size)+(1.-d)/size;
+          const double diff=std::abs(x-v[j]);
+          const double relativeDiff=diff/x;
+
+          if(dangling[j])
+            newDanglingMass+=x;
+          v[j]=x;
+
+          diffNorm+=diff;
+          if(diff>maxDiff)
+            maxDiff=diff;
+          if(relativeDiff>maxRelativeDiff)
+            maxRelativeDiff=relativeDiff;
+        }
+        danglingMass=newDanglingMass;
+
+        if(options.verbose) {
+          cerr << "Itération " << iteration << endl;
+          cerr << "Norme différence : " << diffNorm << endl;
+          cerr << "Max différence : " << maxDiff << endl;
+          cerr << "Différence relative : " << maxRelativeDiff << endl;
+          cerr << endl;
+        }
+
+        if(maxRelativeDiff<options.threshold)
+          break;
+      }
+
+      return iteration;
+    }
+
+    vector<node_t> active(size);
+    for(node_t i=0;i<size;++i)
+      active[i]=i;
+
+    while(iteration<options.maxIterations) {
+      ++iteration;
+
+      const bool fullSweep=!options.adaptive || active.empty() ||
+                           options.fullSweepPeriod<=1 ||
+                           iteration%options.fullSweepPeriod==1;
+
+      if(fullSweep && active.size()!=size) {
+        active.resize(size);
+        for(node_t i=0;i<size;++i)
+          active[i]=i;
+      }
+
+      double diffNorm=0.,maxDiff=0.,maxRelativeDiff=0.;
+      node_t nbActive=0;
+
+      for(node_t k=0,nb=active.size();k<nb;++k) {
+        const node_t j=active[k];
+        const EdgeSpan<const value_t> c=g.columnEdges(j);
+
+        double s=0.;
+        c.forEach([&s,&v](node_t i,value_t w) { s+=v[i]*w; });
+
+        const double x=d*(s+danglingMass/size)+(1.-d)/size;
+        const double diff=std::abs(x-v[j]);
+        const double relativeDiff=diff/x;
+
+        if(dangling[j])
+          danglingMass+=x-v[j];
+        v[j]=x;
+
+        diffNorm+=diff;
+        if(diff>maxDiff)
+          maxDiff=diff;
+        if(relativeDiff>maxRelativeDiff)
+          maxRelativeDiff=relativeDiff;
+
+        // Nodes are kept in their original order, so that the sweep
+        // remains a Gauss-Seidel one
+        if(!options.adaptive || relativeDiff>=options.threshold)
+          active[nbActive++]=j;
+      }
+
+      if(options.verbose) {
+        cerr << "Itération " << iteration
+             << (fullSweep?" (complète)":"") << endl;
+        cerr << "Nœuds mis à jour : " << active.size() << endl;
+        cerr << "Norme différence : " << diffNorm << endl;
+        cerr << "Max différence : " << maxDiff << endl;
+        cerr << "Différence relative : " << maxRelativeDiff << endl;
         cerr << endl;
       }
+
+      active.resize(nbActive);
+
+      if(fullSweep && maxRelativeDiff<options.threshold)
+        break;
     }
-		v=a1;
-  }
-
-//  void anotherInvariantMeasure(const Graph &g, RowVector &v, unsigned niter,
-//                        bool verbose)
-//  {
-//		unsigned int size=g.getNbNodes();
-//    RowVector vo(v),voo(v),w(v),wo(v);
-//		RowVector a1(size),a2(size);
-//		value_t s1,s2,c;
-//    for(unsigned i=0;i<niter;++i) {
-//      if(verbose)
-//        cerr << "Itération " << i << endl;
-//
-//			voo=vo;
-//      vo=v;
-//      v=v*g;
-//			wo=w;
-//			for(node_t i=0;i<size;i++){
-//				a1[i]=vo[i]-voo[i];a2[i]=v[i]+voo[i]-2*vo[i];
-//			}
-//			s1=s2=c=0;
-//			for(node_t i=0;i<size;i++){
-//				s1+=a1[i]*a1[i]/w[i];s2+=a2[i]*a2[i]/w[i];
-//				c+=a1[i]*a2[i]/w[i];
-//			}
-//			s1=c/s2;
-//			for(node_t i=0;i<size;i++){
-//				w[i]=voo[i]-s1*a1[i];
-//			}
-//      
-//      if(verbose) {
-//        cerr << "Somme des éléments de v : " << v.sum() << endl;
-//        cerr << "Somme des éléments de w : " << w.sum() << endl;
-//        cerr << "Norme différence v : " << abs(v-vo).sum() << endl;
-//			a1=w*g;
-//        cerr << "Norme différence w : " << abs(w-a1).sum() << endl;
-//        cerr << "Max différence v : " << abs(v-vo).max() << endl;
-//        cerr << "Max différence w : " << abs(w-a1).max() << endl;
-//        cerr << "Max : " << w.max() << endl;
-//        cerr << "Min : " << w.min() << endl;
-//        cerr << endl;
-//      }
-//    }
-//		if(abs(w-a1).sum()<abs(v-vo).sum())v=w;
-//  }
 
+    return iteration;
+  }
+
+  unsigned long PersonalizedPageRank(const Graph &g, node_t seed,
+                                     NodeArray &result,
+                                     double epsilon, double damping)
+  {
+    // Nodes are queued when their residual exceeds epsilon, and stay
+    // above it until popped
+    unordered_map<node_t,double> score,residual;
+    deque<node_t> queue(1,seed);
+    residual[seed]=1.;
+
+    unsigned long pushes=0;
+
+    while(!queue.empty()) {
+      const node_t u=queue.front();
+      queue.pop_front();
+
+      double &ru=residual[u];
+      const double r=ru;
+      if(r<=epsilon)
+        continue;
+
+      ru=0.;
+      score[u]+=(1.-damping)*r;
+      ++pushes;
+
+      const EdgeSpan<const value_t> row=g.rowEdges(u);
+
+      row.forEach([&](node_t j,value_t w) {
+        double &rv=residual[j];
+        const double old=rv;
+        rv+=damping*r*w;
+        if(old<=epsilon && rv>epsilon)
+          queue.push_back(j);
+      });
+    }
+
+    result.clear();
+    for(unordered_map<node_t,double>::const_iterator it=score.begin(),
+        itend=score.end();
+        it!=itend;
+        ++it)
+      result.insert(it->first,it->second);
+
+    return pushes;
+  }
 
   void Symmetrize(Graph &g, const Vector &measure)
 		//Returns a graph with stationary measure measure
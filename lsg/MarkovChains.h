@@ -25,20 +25,109 @@
 #ifndef MARKOV_CHAINS_H
 #define MARKOV_CHAINS_H
 
+#include <vector>
+
+#include "lsg.h"
+#include "Vector.h"
+
 namespace lsg {
   class Graph;
 	class MutableGraph;
-  class RowVector;
-  class Vector;
+  class NodeArray;
 
   void stochastifyRows(Graph &g);
   void stochastifyColumns(Graph &g);
 
   void InvariantMeasure(const Graph &g, RowVector &v, unsigned niter,
-                        bool verbose);
-		//Applies g niter times to v
-  void anotherInvariantMeasure(const Graph &g, RowVector &v, unsigned niter,
-                        bool verbose);
+                        bool verbose, SpMVKernel kernel=SPMV_DEFAULT);
+		//Applies g niter times to v, with the given product kernel
+
+  enum MeasureSolver {
+    SOLVER_POWER,         // v=v*g
+    SOLVER_QUADRATIC,     // power iterations with periodic quadratic
+    SOLVER_AITKEN,        // or Aitken extrapolation (Kamvar et al.)
+    SOLVER_GMRES,         // restarted GMRES on v(I-g)=0
+    SOLVER_BICGSTAB       // BiCGStab on v(I-g)=0
+  };
+
+  struct InvariantMeasureOptions {
+    InvariantMeasureOptions() :
+      solver(SOLVER_BICGSTAB), tolerance(1e-8), maxIterations(1000),
+      restart(20), extrapolationPeriod(10), kernel(SPMV_DEFAULT),
+      verbose(false) {}
+
+    MeasureSolver solver;
+    double tolerance;        // on the relative residual |v*g-v|/|v|
+    unsigned maxIterations;
+    unsigned restart;        // vectors kept by GMRES
+    unsigned extrapolationPeriod;
+    SpMVKernel kernel;
+    bool verbose;
+  };
+
+  struct InvariantMeasureReport {
+    InvariantMeasureReport() : iterations(0), products(0), converged(false) {}
+
+    unsigned iterations;
+    unsigned long products;            // of a vector by g
+    bool converged;
+    std::vector<double> residuals;     // of the start, then every iterate
+  };
+
+  InvariantMeasureReport InvariantMeasure(const Graph &g, RowVector &v,
+      const InvariantMeasureOptions &options=InvariantMeasureOptions());
+    //Invariant measure of a stochastic graph (rows summing to 1), whose
+    //invariant measure is unique, starting from v (or from the uniform
+    //measure if v has the wrong size) until the relative residual
+    //|v*g-v|/|v| (Euclidean norms) is below tolerance; v is normalized
+    //to sum 1. The Krylov solvers look for v in the affine space of
+    //measures of sum 1, where I-g is invertible; they need far fewer
+    //products than power iterations on slowly mixing graphs. GMRES
+    //keeps restart+1 vectors in memory, and may stall on nearly
+    //symmetric chains when restart is small. Residuals are those of the
+    //successive iterates (as estimated by the Krylov solvers between
+    //restarts); the final one is computed.
+
+  struct PageRankOptions {
+    PageRankOptions() :
+      damping(.85), threshold(.01), maxIterations(1000),
+      adaptive(true), fullSweepPeriod(10), verbose(false),
+      powerIterations(false), kernel(SPMV_DEFAULT) {}
+
+    double damping;
+    double threshold;        // on the maximal relative change of a score
+    unsigned maxIterations;
+    bool adaptive;           // skip the nodes whose score has converged
+    unsigned fullSweepPeriod;// all nodes are updated every such sweep
+    bool verbose;
+    bool powerIterations;    // Jacobi iterations v=v*g instead of sweeps
+    SpMVKernel kernel;       // product kernel of power iterations
+  };
+
+  unsigned PageRank(const Graph &g, RowVector &v,
+                    const PageRankOptions &options=PageRankOptions());
+    //PageRank with uniform teleportation, the mass of dangling nodes
+    //(null rows) being spread uniformly as well. Gauss-Seidel sweeps
+    //over the columns of g update v in place, starting from its current
+    //value (or from the uniform measure if v has the wrong size), until
+    //a sweep over all nodes changes no score by more than threshold
+    //(relatively); returns the number of sweeps. In adaptive mode, nodes
+    //whose score has changed by less than threshold are only updated
+    //every fullSweepPeriod sweeps. With powerIterations, every iteration
+    //is instead a product of v by g with the given kernel (adaptive and
+    //fullSweepPeriod are then ignored); it converges more slowly, but
+    //products are parallel.
+
+  unsigned long PersonalizedPageRank(const Graph &g, node_t seed,
+                                     NodeArray &result,
+                                     double epsilon=1e-7,
+                                     double damping=.85);
+    //PageRank teleporting to seed, approximated by forward push
+    //(Andersen-Chung-Lang) along the rows of g, which should be
+    //stochastic: the residual mass of a node is settled and pushed to
+    //its successors until every residual is below epsilon. Only
+    //visited nodes are touched, and result only contains them. Returns
+    //the number of pushes.
 
   void Symmetrize(Graph &g, const Vector &measure);
     //Returns a graph with stationary measure measure
@@ -33,8 +33,10 @@
 #include <sstream>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
 
 #include "MutableGraph.h"
+#include "Tools.h"
 
 using namespace std;
 
@@ -45,6 +47,38 @@ namespace lsg {
     in >> *this;
   }
 
+  MutableGraph::MutableGraph(const EdgeList &edges)
+  {
+    // Edges are parsed in parallel, then inserted sequentially
+    struct ParsedEdge { node_t i; node_t j; value_t v; };
+    const node_t n=edges.getNbNodes();
+    const unsigned nbThreads=getNbThreads();
+    vector<vector<ParsedEdge> > parsed(nbThreads);
+    vector<char> inRange(nbThreads,1);
+
+    const bool syntaxOk=edges.parse(
+        [n,&parsed,&inRange](unsigned t,node_t i,node_t j,value_t v) {
+          if(i>=n || j>=n)
+            inRange[t]=0;
+          else
+            parsed[t].push_back(ParsedEdge{i,j,v});
+        },nbThreads);
+
+    if(!edges.isOk() || !syntaxOk ||
+       count(inRange.begin(),inRange.end(),0))
+      throw domain_error("Invalid edge list");
+
+    with_labels=false;
+    initialize(n);
+
+    BatchInsertor bi(*this);
+    for(unsigned t=0;t<nbThreads;++t) {
+      for(size_t k=0;k<parsed[t].size();++k)
+        bi.add(parsed[t][k].i,parsed[t][k].j,parsed[t][k].v);
+      vector<ParsedEdge>().swap(parsed[t]);
+    }
+  }
+
   istream &operator>>(istream &in, MutableGraph &g)
   {
     g.destroy();
@@ -177,7 +211,7 @@ namespace lsg {
       *it=value_t();
 
       (*rows)[i]->erase(it);
-      (*columns)[i]->remove(j);
+      (*columns)[j]->remove(i);
     }
   }
 
@@ -316,6 +350,7 @@ namespace lsg {
     vector<MGSparseArray*> *temp=rows;
     rows=columns;
     columns=temp;
+    forgetPartitions();
   }
 
   string MutableGraph::getLabel(node_t i) const
@@ -370,34 +405,25 @@ namespace lsg {
              mem_fun(&MGSparseArray::consolidate));
   }
 
-  void MutableGraph::writeValues(FILE *f) const
-  {
-    node_t size=values.size();
-    std::cerr << "Writing " << size << " values from " << ftell(f) << std::endl;
-
-    for(node_t i=0;i<size;++i)
-      fwrite(&values[i],sizeof(value_t),1,f);
-  }
-
-  struct AddSize : binary_function<node_t,
+  struct AddSize : binary_function<edge_t,
                                    MGSparseArray *, 
-                                   node_t> {
-    inline node_t operator()(node_t sum, MGSparseArray *array)
+                                   edge_t> {
+    inline edge_t operator()(edge_t sum, MGSparseArray *array)
     {
       return sum+array->size();
     }
   };
 
-  node_t MutableGraph::getNbEdges() const
+  edge_t MutableGraph::getNbEdges() const
   {
-    return accumulate(rows->begin(),rows->end(),0,AddSize());
+    return accumulate(rows->begin(),rows->end(),edge_t(0),AddSize());
   }
 
   void MutableGraph::BatchInsertor::add(node_t i, node_t j, value_t value)
   {
     graph.values.push_back(value);
 
-    node_t edge=graph.values.size()-1;
+    edge_t edge=graph.values.size()-1;
 
     (*graph.rows)[i]->insert_unordered(j,edge);
     (*graph.columns)[j]->insert_unordered(i,edge);
@@ -426,7 +452,7 @@ namespace lsg {
   SparseArray::iterator MGSparseArray::find(node_t index)
   {
     pair<vec_t::iterator,vec_t::iterator> range=
-      equal_range(vec.begin(),vec.end(),make_pair(index,0),
+      equal_range(vec.begin(),vec.end(),make_pair(index,edge_t(0)),
           MGSparseArrayLess());
 
     if(range.first==range.second)
@@ -438,7 +464,7 @@ namespace lsg {
   SparseArray::const_iterator MGSparseArray::find(node_t index) const
   {
     pair<vec_t::const_iterator,vec_t::const_iterator> range=
-      equal_range(vec.begin(),vec.end(),make_pair(index,0),
+      equal_range(vec.begin(),vec.end(),make_pair(index,edge_t(0)),
           MGSparseArrayLess());
 
     if(range.first==range.second)
@@ -447,10 +473,10 @@ namespace lsg {
       return buildIterator(range.first);
   }
 
-  SparseArray::iterator MGSparseArray::insert(node_t index, node_t edge)
+  SparseArray::iterator MGSparseArray::insert(node_t index, edge_t edge)
   {
     pair<vec_t::iterator,vec_t::iterator> range=
-      equal_range(vec.begin(),vec.end(),make_pair(index,0),
+      equal_range(vec.begin(),vec.end(),make_pair(index,edge_t(0)),
                   MGSparseArrayLess());
     
     if(range.first==range.second)
@@ -473,29 +499,19 @@ namespace lsg {
   void MGSparseArray::remove(node_t index)
   {
     pair<vec_t::iterator,vec_t::iterator> range=
-      equal_range(vec.begin(),vec.end(),make_pair(index,0),
+      equal_range(vec.begin(),vec.end(),make_pair(index,edge_t(0)),
                   MGSparseArrayLess());
     
     if(range.first!=range.second)
       vec.erase(range.first);   
   }
     
-  SparseArray::iterator MGSparseArray::insert(node_t index, node_t edge,
+  SparseArray::iterator MGSparseArray::insert(node_t index, edge_t edge,
                                               const vec_t::iterator &it)
   {
     return buildIterator(vec.insert(it,make_pair(index,edge)));
   }
 
-  void MGSparseArray::write(FILE *f) const
-  {
-    node_t size=vec.size();
-    fwrite(&size,sizeof(node_t),1,f);
-    for(node_t i=0;i<size;++i) {
-      fwrite(&vec[i].first,sizeof(node_t),1,f);
-      fwrite(&vec[i].second,sizeof(node_t),1,f);
-    }
-  }
-
   void MGSparseArray::consolidate()
   {
     sort(vec.begin(),vec.end(),MGSparseArrayLess());
@@ -33,20 +33,21 @@
 
 #include "Uncopyable.h"
 #include "Graph.h"
+#include "EdgeList.h"
 
 namespace lsg {
   template<typename Value> struct MGValueTraits {
-    typedef std::vector<std::pair<node_t,node_t> >::iterator iterator;
+    typedef std::vector<std::pair<node_t,edge_t> >::iterator iterator;
   };
 
   template<typename Value> struct MGValueTraits<const Value> {
-    typedef std::vector<std::pair<node_t,node_t> >
+    typedef std::vector<std::pair<node_t,edge_t> >
       ::const_iterator iterator;
   };
 
   template<typename Value> class MGSparseArrayIterator :
     public ISparseArrayIterator<Value>, private Uncopyable {
-    typedef std::pair<node_t,node_t> pair_t;
+    typedef std::pair<node_t,edge_t> pair_t;
 
     std::vector<value_t> &values;
     typename MGValueTraits<Value>::iterator it;
@@ -63,11 +64,6 @@ namespace lsg {
     inline virtual Value &operator*() const { return values[it->second]; }
     inline virtual void operator++() { ++it; }
     inline virtual node_t index() const { return it->first; }
-    inline virtual void write(FILE *f) const
-    {
-      fwrite(&it->first,sizeof(node_t),1,f);
-      fwrite(&it->second,sizeof(node_t),1,f);
-    }
     
     virtual bool operator==(const ISparseArrayIterator<Value> &sai) const
     {
@@ -87,7 +83,7 @@ namespace lsg {
   };
 
   class MGSparseArray : public SparseArray, private Uncopyable {
-    typedef std::vector<std::pair<node_t,node_t> > vec_t;
+    typedef std::vector<std::pair<node_t,edge_t> > vec_t;
 
     vec_t vec;
     std::vector<value_t> &values;
@@ -127,7 +123,7 @@ namespace lsg {
       }
     };
 
-    SparseArray::iterator insert(node_t index, node_t edge,
+    SparseArray::iterator insert(node_t index, edge_t edge,
                                  const vec_t::iterator &it);
 
    public:
@@ -151,15 +147,36 @@ namespace lsg {
 
     inline virtual node_t size() const { return vec.size(); }
     
-    virtual void write(FILE *f) const;
-    
     // Other methods
-    SparseArray::iterator insert(node_t index, node_t edge);
+    SparseArray::iterator insert(node_t index, edge_t edge);
     void erase(const SparseArray::iterator &it);
     void remove(node_t index);
-    inline void insert_unordered(node_t index, node_t edge)
+    inline void insert_unordered(node_t index, edge_t edge)
       { vec.push_back(std::make_pair(index,edge)); }
     void consolidate();
+
+    // Node indices and value indices are read in place, striding over
+    // the pairs of the underlying std::vector
+    inline EdgeSpan<value_t> edges()
+      { return EdgeSpan<value_t>(indices(),nodeStride,
+                                 valueIndices(),edgeStride,
+                                 vec.size(),values.data()); }
+    inline EdgeSpan<const value_t> edges() const
+      { return EdgeSpan<const value_t>(indices(),nodeStride,
+                                       valueIndices(),edgeStride,
+                                       vec.size(),values.data()); }
+
+   private:
+    static const unsigned nodeStride=sizeof(vec_t::value_type)/sizeof(node_t);
+    static const unsigned edgeStride=sizeof(vec_t::value_type)/sizeof(edge_t);
+    static_assert(sizeof(vec_t::value_type)%sizeof(node_t)==0 &&
+                  sizeof(vec_t::value_type)%sizeof(edge_t)==0,
+                  "pairs must be seen as arrays of node_t and edge_t");
+
+    inline const node_t *indices() const
+      { return vec.empty()?0:&vec.front().first; }
+    inline const edge_t *valueIndices() const
+      { return vec.empty()?0:&vec.front().second; }
   };
   
   class MutableGraph: public Graph {
@@ -167,6 +184,9 @@ namespace lsg {
       // Constructors
       MutableGraph(node_t nbNodes=0);
       MutableGraph(std::istream &is);
+      // Parsed in parallel; throws a domain_error if the edge list is
+      // invalid
+      explicit MutableGraph(const EdgeList &edges);
       MutableGraph(const Graph &g);
       MutableGraph(const Graph &g,const std::vector<bool> &nodes);
       MutableGraph(const MutableGraph &g);
@@ -182,13 +202,22 @@ namespace lsg {
       inline virtual node_t getNbNodes() const { return size; }
       inline virtual bool hasLabels() const { return with_labels; }
       inline virtual bool hasValues() const { return true; }
-      virtual node_t getNbEdges() const;
+      virtual edge_t getNbEdges() const;
 
       inline virtual SparseArray &row(node_t i) { return *(*rows)[i]; }
       inline virtual SparseArray &column(node_t j) { return *(*columns)[j]; }
       inline virtual const SparseArray &row(node_t i) const { return *(*rows)[i]; }
       inline virtual const SparseArray &column(node_t j) const {return *(*columns)[j];}
 
+      inline virtual EdgeSpan<value_t> rowEdges(node_t i)
+        { return (*rows)[i]->edges(); }
+      inline virtual EdgeSpan<value_t> columnEdges(node_t j)
+        { return (*columns)[j]->edges(); }
+      inline virtual EdgeSpan<const value_t> rowEdges(node_t i) const
+        { return static_cast<const MGSparseArray *>((*rows)[i])->edges(); }
+      inline virtual EdgeSpan<const value_t> columnEdges(node_t j) const
+        { return static_cast<const MGSparseArray *>((*columns)[j])->edges(); }
+
       virtual std::string getLabel(node_t i) const;
       virtual void setLabel(node_t i,const std::string &s);
       virtual std::string::size_type getLabelSize(node_t i) const;
@@ -227,7 +256,6 @@ namespace lsg {
       void copy(const Graph &g);
       void consolidate();
 
-      virtual void writeValues(FILE *f) const;
       virtual value_t &insert_new_edge(node_t i,node_t j);
   
       friend std::istream &operator>>(std::istream &in, MutableGraph &g);
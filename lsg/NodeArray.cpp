@@ -23,6 +23,7 @@
  */
 
 #include <stdexcept>
+#include <algorithm>
 
 #include "NodeArray.h"
 #include "Graph.h"
@@ -44,26 +45,116 @@ namespace lsg {
 namespace {
   using namespace lsg;
 
-  void propagate(const Graph &g, NodeArray &na, bool backward)
-  {
-    NodeArray result;
-
-    for(SparseArray::iterator it=na.begin(),
-                           itend=na.end();
-        it!=itend;
-        ++it) {
-      const SparseArray &gsa=backward?g.column(it.index()):g.row(it.index());
-      
-      for(SparseArray::const_iterator git=gsa.begin(),
-                                   gitend=gsa.end();
-          git!=gitend;
-          ++git) {
-        result.insert(git.index(),1.);
+  // Frontiers with more than 1/SPARSE_FRACTION of the nodes are bitmaps
+  const node_t SPARSE_FRACTION=24;
+  // A hop goes bottom-up (from all nodes, see Frontiers::hop) when the
+  // frontier has more than 1/BOTTOM_UP_FRACTION of the edges to go through
+  const edge_t BOTTOM_UP_FRACTION=14;
+
+  // Nodes reached after some hops: an increasing list of nodes while
+  // there are few of them, a bitmap otherwise
+  struct Frontier {
+    bool dense;
+    vector<node_t> nodes;
+    vector<bool> bits;
+
+    template<class F> void forEach(F f) const
+    {
+      if(dense) {
+        for(node_t i=0;i<bits.size();++i)
+          if(bits[i])
+            f(i);
+      } else
+        for(vector<node_t>::const_iterator it=nodes.begin();
+            it!=nodes.end();++it)
+          f(*it);
+    }
+  };
+
+  class Frontiers {
+   public:
+    Frontiers(const Graph &graph) :
+      g(graph), n(graph.getNbNodes()), mark(n,false) {}
+
+    // out=nodes linked to in, forward or backward. Top-down, the edges
+    // of in are gone through; bottom-up, every node looks for a
+    // neighbour in in, and stops at the first one
+    void hop(const Frontier &in,bool backward,Frontier &out)
+    {
+      edge_t work=0;
+      in.forEach([&](node_t i) { work+=edges(i,backward).size(); });
+
+      out.nodes.clear();
+      out.bits.clear();
+
+      if(work*BOTTOM_UP_FRACTION>g.getNbEdges()) {
+        const vector<bool> *inBits=&in.bits;
+        if(!in.dense) {
+          for(vector<node_t>::const_iterator it=in.nodes.begin();
+              it!=in.nodes.end();++it)
+            mark[*it]=true;
+          inBits=&mark;
+        }
+
+        node_t count=0;
+        out.bits.assign(n,false);
+        for(node_t j=0;j<n;++j) {
+          const EdgeSpan<const value_t> r=edges(j,!backward);
+          for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+              it!=itend;++it)
+            if((*inBits)[it.index()]) {
+              out.bits[j]=true;
+              ++count;
+              break;
+            }
+        }
+
+        if(!in.dense)
+          for(vector<node_t>::const_iterator it=in.nodes.begin();
+              it!=in.nodes.end();++it)
+            mark[*it]=false;
+
+        out.dense=count*SPARSE_FRACTION>n;
+        if(!out.dense) {
+          out.nodes.reserve(count);
+          for(node_t j=0;j<n;++j)
+            if(out.bits[j])
+              out.nodes.push_back(j);
+          out.bits.clear();
+        }
+      } else {
+        in.forEach([&](node_t i) {
+          const EdgeSpan<const value_t> r=edges(i,backward);
+          for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+              it!=itend;++it)
+            if(!mark[it.index()]) {
+              mark[it.index()]=true;
+              out.nodes.push_back(it.index());
+            }
+        });
+
+        out.dense=out.nodes.size()*SPARSE_FRACTION>n;
+        if(out.dense) {
+          out.bits.swap(mark);
+          mark.assign(n,false);
+          out.nodes.clear();
+        } else {
+          sort(out.nodes.begin(),out.nodes.end());
+          for(vector<node_t>::const_iterator it=out.nodes.begin();
+              it!=out.nodes.end();++it)
+            mark[*it]=false;
+        }
       }
     }
 
-    na=result;
-  }
+   private:
+    inline EdgeSpan<const value_t> edges(node_t i,bool backward) const
+      { return backward?g.columnEdges(i):g.rowEdges(i); }
+
+    const Graph &g;
+    node_t n;
+    vector<bool> mark;  // Scratch bitmap, all false between hops
+  };
 }
 
 namespace lsg {
@@ -71,16 +162,41 @@ namespace lsg {
     (const Graph &g, node_t node, const std::string &direction,
      NodeArray &result)
   {
-    if(direction.find_first_not_of("FB")!=string::npos)
-      throw std::invalid_argument("Incorrect direction string");
+    vector<NodeArray> results;
+    directedSpheres(g,node,vector<string>(1,direction),results);
+    result=results[0];
+  }
+
+  void directedSpheres
+    (const Graph &g, node_t node, const vector<string> &directions,
+     vector<NodeArray> &results)
+  {
+    for(unsigned k=0;k<directions.size();++k)
+      if(directions[k].find_first_not_of("FB")!=string::npos)
+        throw std::invalid_argument("Incorrect direction string");
+
+    Frontiers frontiers(g);
+
+    // Frontiers reached by every prefix computed so far
+    map<string,Frontier> reached;
+    reached[""].dense=false;
+    reached[""].nodes.push_back(node);
 
-    result.clear();
-    
-    result.insert(node,1.);
+    results.resize(directions.size());
+    for(unsigned k=0;k<directions.size();++k) {
+      const string &direction=directions[k];
 
-    std::string::size_type size=direction.size();
-    for(std::string::size_type i=0;i<size;++i)
-      propagate(g,result,direction[i]=='B'?true:false);
+      string::size_type l=direction.size();
+      while(!reached.count(direction.substr(0,l)))
+        --l;
+      for(;l<direction.size();++l)
+        frontiers.hop(reached[direction.substr(0,l)],direction[l]=='B',
+                      reached[direction.substr(0,l+1)]);
+
+      NodeArray &result=results[k];
+      result.clear();
+      reached[direction].forEach([&](node_t i) { result.append(i,1.); });
+    }
   }
 
 	void addNodeArray(const NodeArray& a1,const NodeArray& a2,NodeArray& result)
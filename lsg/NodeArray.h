@@ -26,6 +26,8 @@
 #define NODEARRAY_H
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include "SparseArray.h"
 
@@ -108,6 +110,9 @@ namespace lsg {
     // Other methods
     inline void insert(node_t index, value_t value)
       { m.insert(std::make_pair(index,value)); }
+    // Insertion of an index larger than all others, in constant time
+    inline void append(node_t index, value_t value)
+      { m.insert(m.end(),std::make_pair(index,value)); }
     inline void clear()
       { m.clear();}
 		
@@ -127,9 +132,19 @@ namespace lsg {
     std::map<node_t,value_t> m;
   };
 
+  // Nodes (with value 1) reached from node by following, for every
+  // character of direction, edges forward (F) or backward (B). Every hop
+  // goes top-down or bottom-up, like direction-optimizing BFS, depending
+  // on the number of edges the nodes reached so far have.
   void directedSphere
     (const Graph &g, node_t node, const std::string &direction,
      NodeArray &result);
+
+  // Spheres for several directions; common prefixes are only computed
+  // once
+  void directedSpheres
+    (const Graph &g, node_t node, const std::vector<std::string> &directions,
+     std::vector<NodeArray> &results);
 		
 	void AddNodeArray(const NodeArray& a1,const NodeArray& a2,NodeArray& result);
 	void MultNodeArray(const NodeArray& a1,const NodeArray& a2,NodeArray& result);
@@ -27,19 +27,126 @@
 #include <unistd.h>
 
 #include <stdexcept>
+#include <cstdlib>
 #include <cassert>
 #include <cstring>
 
 #include "SparseArray.h"
 #include "PackedGraph.h"
+#include "GraphWriter.h"
 #include "Tools.h"
 
 using namespace std;
 
+namespace {
+  // Address following p, aligned (with respect to base) to size
+  inline char *alignedAfter(char *base,const void *p,size_t size)
+  {
+    const size_t offset=static_cast<const char *>(p)-base;
+    return base+(offset+size-1)/size*size;
+  }
+
+  bool adviseRegion(void *region,size_t length,lsg::GraphAccess access)
+  {
+    static const int advice[]=
+      {MADV_NORMAL,MADV_SEQUENTIAL,MADV_RANDOM,MADV_WILLNEED};
+
+    return !madvise(region,length,advice[access]);
+  }
+
+  // Maps the file fd of the given length as asked by options
+  bool mapFile(int fd,size_t length,const lsg::PackedGraphOptions &options,
+               void *&region)
+  {
+    int flags=MAP_SHARED;
+#ifdef MAP_POPULATE
+    // Huge pages must be asked for before the pages are read
+    bool populated=options.populate && !options.hugePages;
+    if(populated)
+      flags|=MAP_POPULATE;
+#else
+    bool populated=false;
+#endif
+
+    region=mmap(0,length,
+                options.readOnly?PROT_READ:PROT_READ|PROT_WRITE,flags,fd,0);
+    if(region==MAP_FAILED)
+      return false;
+
+#ifdef MADV_HUGEPAGE
+    if(options.hugePages)
+      madvise(region,length,MADV_HUGEPAGE);
+#endif
+
+    if(!adviseRegion(region,length,options.access))
+      return false;
+
+    if(options.populate && !populated) {
+      // One read per page
+      const volatile char *const base=
+        reinterpret_cast<const volatile char *>(region);
+      const long pageSize=sysconf(_SC_PAGESIZE);
+      for(size_t k=0;k<length;k+=pageSize)
+        (void) base[k];
+    }
+
+    if(options.lock && mlock(region,length))
+      return false;
+
+    return true;
+  }
+
+  string directoryOf(const string &path)
+  {
+    const string::size_type slash=path.rfind('/');
+    return slash==string::npos?".":slash==0?"/":path.substr(0,slash);
+  }
+
+  string realPath(const string &path)
+  {
+    char *p=realpath(path.c_str(),0);
+    if(!p)
+      return "";
+    string result=p;
+    free(p);
+    return result;
+  }
+
+  // Path of file, as recorded in a value file stored as valueFile:
+  // relative to the directory of valueFile if file is in that
+  // directory, absolute otherwise
+  string recordedPath(const string &file,const string &valueFile)
+  {
+    const string directory=realPath(directoryOf(file));
+    if(!directory.empty() && directory==realPath(directoryOf(valueFile)))
+      return file.substr(file.rfind('/')+1);
+
+    const string absolute=realPath(file);
+    return absolute.empty()?file:absolute;
+  }
+
+  // Offset of the path of the graph file in a value file
+  const size_t VALUE_FILE_PATH=lsg::EXTENDED_HEADER_SIZE+sizeof(uint64_t);
+}
+
 namespace lsg {
-  PackedGraph::PackedGraph(const string &filename)
+  PackedGraph::PackedGraph(const string &filename,
+                           const PackedGraphOptions &options) :
+    size(0), nbEdges(0), with_labels(false), with_values(false),
+    with_transpose(false), is_transposed(false),
+    read_only(options.readOnly),
+    indexr(0), indexc(0), indexl(0), rows(0), columns(0),
+    firstr(0), firstc(0), label_offsets(0),
+    row_indices(0), column_indices(0), column_value_indices(0),
+    offsetr(0), offsetc(0), row_stream(0), column_stream(0),
+    values(0), labels(0), nbLabelBuckets(0), labelBuckets(0),
+    mmaped_region(MAP_FAILED), filesize(0),
+    value_region(MAP_FAILED), value_filesize(0),
+    sparse_rows(0), sparse_columns(0),
+    compressed_rows(0), compressed_columns(0),
+    split_rows(0), split_columns(0)
   {
-    fd=open(filename.c_str(),O_RDWR);
+    fd=open(filename.c_str(),read_only?O_RDONLY:O_RDWR);
 
     if(fd==-1)
       return;
@@ -47,6 +154,30 @@ namespace lsg {
     char magic[4];
     if(read(fd,magic,4)!=4)
       return;
+
+    graph_file=filename;
+    PackedGraphOptions graphOptions=options;
+    value_t *file_values=0;
+    uint64_t value_fields[3];
+    bool values_transposed=false;
+
+    if(!strncmp(magic,"GPV",3)) {
+      // The graph file of a value file may be shared with other value
+      // files: it is only read
+      values_transposed=(magic[3]&MAGIC_IS_TRANSPOSED);
+      const bool mapped=map_value_file(filename,options,file_values,
+                                       value_fields);
+      close(fd);
+      fd=-1;
+      if(!mapped)
+        return;
+
+      graphOptions.readOnly=true;
+      fd=open(graph_file.c_str(),O_RDONLY);
+      if(fd==-1 || read(fd,magic,4)!=4)
+        return;
+    }
+
     if(strncmp(magic,"GPH",3))
       return;
 
@@ -54,75 +185,270 @@ namespace lsg {
     with_transpose=(magic[3]&MAGIC_WITH_TRANSPOSE);
     with_labels=(magic[3]&MAGIC_WITH_LABELS);
     is_transposed=(magic[3]&MAGIC_IS_TRANSPOSED);
+    const bool extended=(magic[3]&MAGIC_EXTENDED);
+
+    off_t position;
+    uint64_t fields[3];
+
+    if(extended) {
+      if(lseek(fd,8,SEEK_SET)!=8 ||
+         read(fd,fields,sizeof(fields))!=sizeof(fields))
+        return;
+
+      if(((fields[0]&EXTENDED_WIDE_NODES)!=0)!=
+         (sizeof(node_t)==sizeof(uint64_t)) ||
+         ((fields[0]&EXTENDED_FLOAT_VALUES)!=0)!=
+         (sizeof(value_t)==sizeof(float)))
+        return;
+
+      size=fields[1];
+      nbEdges=fields[2];
+      position=EXTENDED_HEADER_SIZE;
+    } else {
+      // Plain format files have 32-bit nodes and double values
+      if(sizeof(node_t)!=sizeof(uint32_t) ||
+         (with_values && sizeof(value_t)!=sizeof(double)))
+        return;
+
+      seekTillAlign(fd,sizeof(uint32_t));
+
+      uint32_t s,e;
+      if(read(fd,&s,sizeof(uint32_t))!=sizeof(uint32_t) ||
+         read(fd,&e,sizeof(uint32_t))!=sizeof(uint32_t))
+        return;
+
+      size=s;
+      nbEdges=e;
+      position=lseek(fd,0,SEEK_CUR);
+    }
 
-    seekTillAlign(fd,sizeof(node_t));
+    filesize=lseek(fd,0,SEEK_END);
+    lseek(fd,0,SEEK_SET);
 
-    if(read(fd,&size,sizeof(node_t))!=sizeof(node_t))
+    if(!mapFile(fd,filesize,graphOptions,mmaped_region))
       return;
 
-    if(read(fd,&nbEdges,sizeof(node_t))!=sizeof(node_t))
+    if(!(extended?map_extended(magic[3]):map_plain(position)))
       return;
 
-    off_t position=lseek(fd,0,SEEK_CUR);
-    filesize=lseek(fd,0,SEEK_END);
-    lseek(fd,0,SEEK_SET);
+    if(with_labels && (magic[3]&MAGIC_WITH_LABEL_INDEX)) {
+      const char *end=labels;
+      if(size>0)
+        end=labels+label_offset(size-1)+strlen(labels+label_offset(size-1))+1;
+
+      char *const base=reinterpret_cast<char *>(mmaped_region);
+
+      if(extended) {
+        const edge_t *pos=reinterpret_cast<const edge_t *>(
+            alignedAfter(base,end,sizeof(edge_t)));
+
+        if(reinterpret_cast<const char *>(pos+1)<=base+filesize) {
+          nbLabelBuckets=*pos;
+          labelBuckets=reinterpret_cast<const node_t *>(pos+1);
+        }
+      } else {
+        const unsigned long *pos=reinterpret_cast<const unsigned long *>(
+            alignedAfter(base,end,sizeof(unsigned long)));
+
+        if(reinterpret_cast<const char *>(pos+1)<=base+filesize) {
+          nbLabelBuckets=*pos;
+          labelBuckets=reinterpret_cast<const node_t *>(pos+1);
+        }
+      }
+    }
+
+    if(file_values) {
+      if(!with_values || value_fields[1]!=size || value_fields[2]!=nbEdges)
+        return;
+
+      values=file_values;
+      is_transposed=values_transposed;
+    }
+
+    init_sparse_arrays();
 
-    mmaped_region=mmap(0,filesize,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    if(is_transposed)
+      swap_rows_columns();
+      
+    setOk();
+  }
+
+  bool PackedGraph::map_value_file(const string &filename,
+                                   const PackedGraphOptions &options,
+                                   value_t *&file_values,
+                                   uint64_t fields[3])
+  {
+    value_filesize=lseek(fd,0,SEEK_END);
+    if(value_filesize<static_cast<off_t>(VALUE_FILE_PATH) ||
+       !mapFile(fd,value_filesize,options,value_region))
+      return false;
+
+    char *const base=reinterpret_cast<char *>(value_region);
+    memcpy(fields,base+8,3*sizeof(uint64_t));
+    if(((fields[0]&EXTENDED_FLOAT_VALUES)!=0)!=
+       (sizeof(value_t)==sizeof(float)))
+      return false;
+
+    uint64_t length;
+    memcpy(&length,base+EXTENDED_HEADER_SIZE,sizeof(uint64_t));
+    if(length>static_cast<uint64_t>(value_filesize)-VALUE_FILE_PATH)
+      return false;
+
+    const string path(base+VALUE_FILE_PATH,length);
+    graph_file=path[0]=='/'?path:directoryOf(filename)+"/"+path;
+
+    file_values=reinterpret_cast<value_t *>(
+        alignedAfter(base,base+VALUE_FILE_PATH+length,sizeof(edge_t)));
+    return reinterpret_cast<char *>(file_values+fields[2])<=
+      base+value_filesize;
+  }
+
+  bool PackedGraph::hasValueFile() const
+  {
+    return value_region!=MAP_FAILED;
+  }
+
+  bool PackedGraph::storeValues(const string &filename) const
+  {
+    if(!with_values)
+      return false;
+
+    const string path=recordedPath(graph_file,filename);
+
+    FILE *f=fopen(filename.c_str(),"wb");
+    if(!f)
+      return false;
+
+    char header[VALUE_FILE_PATH];
+    makeExtendedHeader(header,0,size,nbEdges);
+    memcpy(header,"GPV",3);
+    header[3]=is_transposed?MAGIC_IS_TRANSPOSED:0;
+    const uint64_t length=path.size();
+    memcpy(header+EXTENDED_HEADER_SIZE,&length,sizeof(uint64_t));
+
+    const char padding[sizeof(edge_t)]={0};
+    const size_t nbPadding=
+      (sizeof(edge_t)-(VALUE_FILE_PATH+length)%sizeof(edge_t))%
+      sizeof(edge_t);
+
+    bool ok=fwrite(header,1,VALUE_FILE_PATH,f)==VALUE_FILE_PATH &&
+      fwrite(path.c_str(),1,length,f)==length &&
+      fwrite(padding,1,nbPadding,f)==nbPadding &&
+      fwrite(values,sizeof(value_t),nbEdges,f)==nbEdges;
+
+    return !fclose(f) && ok;
+  }
+
+  bool PackedGraph::advise(GraphAccess access) const
+  {
     if(mmaped_region==MAP_FAILED)
-      return;
+      return false;
 
-    indexr=reinterpret_cast<unsigned long *>(
-        reinterpret_cast<char *>(mmaped_region)+position);
+    return adviseRegion(mmaped_region,filesize,access) &&
+      (value_region==MAP_FAILED ||
+       adviseRegion(value_region,value_filesize,access));
+  }
 
-    if(with_transpose)
-      indexc=indexr+size;
-    if(with_labels)
-      indexl=(with_transpose?indexc:indexr)+size;
+  bool PackedGraph::map_plain(off_t position)
+  {
+    char *const base=reinterpret_cast<char *>(mmaped_region);
 
-    rows=reinterpret_cast<node_t*>(const_cast<unsigned long *>(
-        indexr+(1+(with_transpose?1:0)+(with_labels?1:0))*size));
+    if(!with_transpose)
+      return false;
 
-    if(with_transpose)
-      columns=rows+nbEdges*(with_values?2:1)+size;
+    indexr=reinterpret_cast<unsigned long *>(base+position);
+    indexc=indexr+size;
+    if(with_labels)
+      indexl=indexc+size;
 
-    if(with_values) {
-      char *pos=reinterpret_cast<char *>
-        (((with_transpose?columns:rows)+nbEdges*2+size));
+    rows=reinterpret_cast<const uint32_t *>(
+        indexr+(2+(with_labels?1:0))*size);
+    columns=rows+nbEdges*(with_values?2:1)+size;
 
-      ptrdiff_t offset=
-        sizeof(value_t)-
-        (pos-reinterpret_cast<char *>(mmaped_region))%sizeof(value_t);
-      
-      if(offset==sizeof(value_t))
-        offset=0;
+    char *const end_of_edges=const_cast<char *>(reinterpret_cast<const char *>
+      (columns+nbEdges*(with_values?2:1)+size));
 
-      values=reinterpret_cast<value_t *>(pos+offset);
+    if(with_values) {
+      values=reinterpret_cast<value_t *>(
+          alignedAfter(base,end_of_edges,sizeof(value_t)));
       labels=reinterpret_cast<char*>(values+nbEdges);
     } else if(with_labels)
-      labels=reinterpret_cast<char*>((with_transpose?columns:rows)+
-          nbEdges*(with_values?2:1)+size);
+      labels=end_of_edges;
 
-    init_sparse_arrays();
-
-    if(is_transposed)
-      swap_rows_columns();
-      
-    setOk();
+    return true;
   }
 
-  void PackedGraph::swap_rows_columns()
+  bool PackedGraph::map_extended(unsigned char magic)
   {
-    node_t * const temp=rows;
-    rows=columns;
-    columns=temp;
+    char *const base=reinterpret_cast<char *>(mmaped_region);
+    const edge_t *const tables=
+      reinterpret_cast<const edge_t *>(base+EXTENDED_HEADER_SIZE);
+
+    if(!with_values)
+      return false;
+
+    const void *end_of_edges;
+
+    if(magic&MAGIC_COMPRESSED) {
+      // Stream VByte handles 32-bit integers only
+      if(sizeof(node_t)!=sizeof(uint32_t) || !with_transpose)
+        return false;
+
+      firstr=tables;
+      offsetr=firstr+size+1;
+      firstc=offsetr+size+1;
+      offsetc=firstc+size+1;
+      if(with_labels)
+        label_offsets=offsetc+size+1;
+
+      row_stream=reinterpret_cast<const unsigned char *>(
+          offsetc+size+1+(with_labels?size:0));
+      column_stream=row_stream+offsetr[size]+SVB_PADDING;
+
+      end_of_edges=column_stream+offsetc[size]+SVB_PADDING;
+    } else if(magic&MAGIC_CSR) {
+      // Column tables are omitted in files without transpose
+      firstr=tables;
+      const edge_t *end_of_tables=firstr+size+1;
+      if(with_transpose) {
+        firstc=end_of_tables;
+        end_of_tables+=size+1;
+      }
+      if(with_labels)
+        label_offsets=end_of_tables;
+
+      row_indices=reinterpret_cast<const node_t *>(
+          end_of_tables+(with_labels?size:0));
+      end_of_edges=row_indices+nbEdges;
+
+      if(with_transpose) {
+        column_indices=row_indices+nbEdges;
+        column_value_indices=reinterpret_cast<const edge_t *>(
+            alignedAfter(base,column_indices+nbEdges,sizeof(edge_t)));
+        end_of_edges=column_value_indices+nbEdges;
+      }
+    } else
+      return false;
+
+    values=reinterpret_cast<value_t *>(
+        alignedAfter(base,end_of_edges,sizeof(value_t)));
+    labels=reinterpret_cast<char*>(values+nbEdges);
 
-    const unsigned long* const temp2=indexr;
-    indexr=indexc;
-    indexc=temp2;
+    return labels<=base+filesize;
+  }
 
-    vector<PGSparseArray> *const temp3=sparse_rows;
-    sparse_rows=sparse_columns;
-    sparse_columns=temp3;
+  void PackedGraph::swap_rows_columns()
+  {
+    swap(rows,columns);
+    swap(indexr,indexc);
+    swap(firstr,firstc);
+    swap(offsetr,offsetc);
+    swap(row_indices,column_indices);
+    swap(row_stream,column_stream);
+
+    swap(sparse_rows,sparse_columns);
+    swap(compressed_rows,compressed_columns);
+    swap(split_rows,split_columns);
   }
 
   PackedGraph::~PackedGraph()
@@ -131,12 +457,18 @@ namespace lsg {
 
     delete sparse_columns;
     delete sparse_rows;
+    delete compressed_columns;
+    delete compressed_rows;
+    delete split_columns;
+    delete split_rows;
   }
 
   void PackedGraph::destroy() {
     if(!destroyed) {
       if(mmaped_region!=MAP_FAILED)
         munmap(mmaped_region,filesize);
+      if(value_region!=MAP_FAILED)
+        munmap(value_region,value_filesize);
       if(fd!=-1)
         close(fd);
       destroyed=true;
@@ -153,9 +485,13 @@ namespace lsg {
       throw domain_error("No transposition available");
 
     swap_rows_columns();
+    forgetPartitions();
 
     is_transposed=!is_transposed;
-    reinterpret_cast<char*>(mmaped_region)[3]^=MAGIC_IS_TRANSPOSED;
+    if(!read_only)
+      reinterpret_cast<char*>(value_region!=MAP_FAILED?
+                              value_region:mmaped_region)[3]^=
+        MAGIC_IS_TRANSPOSED;
   }
 
   string PackedGraph::getLabel(node_t i) const
@@ -163,7 +499,7 @@ namespace lsg {
     if(!with_labels)
       return "";
 
-    return labels+indexl[i];
+    return labels+label_offset(i);
   }
 
   size_t PackedGraph::getLabelSize(node_t i) const
@@ -171,7 +507,7 @@ namespace lsg {
     if(!with_labels)
       return 0;
 
-    return strlen(labels+indexl[i]);
+    return strlen(labels+label_offset(i));
   }
 
   node_t PackedGraph::getNodeWithLabel(const string &s) const
@@ -179,8 +515,19 @@ namespace lsg {
     if(with_labels) {
       const char *chaine=s.c_str();
 
+      if(labelBuckets) {
+        edge_t b=hashLabel(chaine)&(nbLabelBuckets-1);
+
+        for(;labelBuckets[b]!=static_cast<node_t>(-1);
+            b=(b+1)&(nbLabelBuckets-1))
+          if(!strcmp(labels+label_offset(labelBuckets[b]),chaine))
+            return labelBuckets[b];
+
+        return static_cast<node_t>(-1);
+      }
+
       for(node_t i=0;i<size;++i) {
-        if(!strcmp(labels+indexl[i],chaine))
+        if(!strcmp(labels+label_offset(i),chaine))
           return i;
       }
     }
@@ -190,29 +537,151 @@ namespace lsg {
 
   void PackedGraph::init_sparse_arrays()
   {
-    sparse_rows=new vector<PGSparseArray>(size);
-    sparse_columns=new vector<PGSparseArray>(size);
+    if(row_indices) {
+      split_rows=new vector<PGSplitSparseArray>(size);
+      for(node_t i=0;i<size;++i)
+        (*split_rows)[i].set(values,row_indices+firstr[i],0,
+                             firstr[i+1]-firstr[i],firstr[i]);
+
+      if(column_indices) {
+        split_columns=new vector<PGSplitSparseArray>(size);
+        for(node_t i=0;i<size;++i)
+          (*split_columns)[i].set(values,column_indices+firstc[i],
+                                  column_value_indices+firstc[i],
+                                  firstc[i+1]-firstc[i],0);
+      }
+    } else if(row_stream) {
+      compressed_rows=new vector<PGCompressedSparseArray>(size);
+      compressed_columns=new vector<PGCompressedSparseArray>(size);
 
-    for(node_t i=0;i<size;++i) {
-      (*sparse_rows)[i].set(values,rows+indexr[i]);
-      (*sparse_columns)[i].set(values,columns+indexc[i]);
+      for(node_t i=0;i<size;++i) {
+        (*compressed_rows)[i].set(values,row_stream+offsetr[i],
+                                  firstr[i+1]-firstr[i],firstr[i],0);
+        (*compressed_columns)[i].set(values,column_stream+offsetc[i],
+                                     firstc[i+1]-firstc[i],0,firstr);
+      }
+    } else {
+      sparse_rows=new vector<PGSparseArray>(size);
+      sparse_columns=new vector<PGSparseArray>(size);
+
+      for(node_t i=0;i<size;++i) {
+        (*sparse_rows)[i].set(values,rows+indexr[i]);
+        (*sparse_columns)[i].set(values,columns+indexc[i]);
+      }
     }
   }
 
-  void PackedGraph::writeValues(FILE *f) const
+  SparseArray &PackedGraph::row(node_t i)
   {
-    fwrite(values,sizeof(value_t),nbEdges,f);
+    if(split_rows)
+      return (*split_rows)[i];
+    if(compressed_rows)
+      return (*compressed_rows)[i];
+
+    return (*sparse_rows)[i];
   }
-    
-  void PGSparseArray::write(FILE *f) const
+
+  SparseArray &PackedGraph::column(node_t j)
   {
-    fwrite(start,sizeof(node_t),1+2*size(),f);
+    if(split_columns)
+      return (*split_columns)[j];
+    if(compressed_columns)
+      return (*compressed_columns)[j];
+    if(!sparse_columns)
+      throw domain_error("No transposition available");
+
+    return (*sparse_columns)[j];
   }
-    
+
+  const SparseArray &PackedGraph::row(node_t i) const
+  {
+    return const_cast<PackedGraph *>(this)->row(i);
+  }
+
+  const SparseArray &PackedGraph::column(node_t j) const
+  {
+    return const_cast<PackedGraph *>(this)->column(j);
+  }
+
+  node_t PackedGraph::rowSize(node_t i) const
+  {
+    if(firstr)
+      return firstr[i+1]-firstr[i];
+
+    return (*sparse_rows)[i].size();
+  }
+
+  node_t PackedGraph::columnSize(node_t j) const
+  {
+    if(firstc)
+      return firstc[j+1]-firstc[j];
+    if(!sparse_columns)
+      throw domain_error("No transposition available");
+
+    return (*sparse_columns)[j].size();
+  }
+
+  namespace {
+    thread_local vector<uint32_t> rowBuffer;
+    thread_local vector<edge_t> rowValueIndexBuffer;
+    thread_local vector<uint32_t> columnBuffer;
+    thread_local vector<edge_t> columnValueIndexBuffer;
+  }
+
+  EdgeSpan<value_t> PackedGraph::rowEdges(node_t i)
+  {
+    if(split_rows)
+      return (*split_rows)[i].edges();
+    if(compressed_rows)
+      return (*compressed_rows)[i].edges(rowBuffer,rowValueIndexBuffer);
+
+    return (*sparse_rows)[i].edges();
+  }
+
+  EdgeSpan<value_t> PackedGraph::columnEdges(node_t j)
+  {
+    if(split_columns)
+      return (*split_columns)[j].edges();
+    if(compressed_columns)
+      return (*compressed_columns)[j].edges(columnBuffer,
+                                            columnValueIndexBuffer);
+    if(!sparse_columns)
+      throw domain_error("No transposition available");
+
+    return (*sparse_columns)[j].edges();
+  }
+
+  EdgeSpan<const value_t> PackedGraph::rowEdges(node_t i) const
+  {
+    if(split_rows)
+      return static_cast<const PGSplitSparseArray &>(
+          (*split_rows)[i]).edges();
+    if(compressed_rows)
+      return static_cast<const PGCompressedSparseArray &>(
+          (*compressed_rows)[i]).edges(rowBuffer,rowValueIndexBuffer);
+
+    return static_cast<const PGSparseArray &>((*sparse_rows)[i]).edges();
+  }
+
+  EdgeSpan<const value_t> PackedGraph::columnEdges(node_t j) const
+  {
+    if(split_columns)
+      return static_cast<const PGSplitSparseArray &>(
+          (*split_columns)[j]).edges();
+    if(compressed_columns)
+      return static_cast<const PGCompressedSparseArray &>(
+          (*compressed_columns)[j]).edges(columnBuffer,
+                                          columnValueIndexBuffer);
+    if(!sparse_columns)
+      throw domain_error("No transposition available");
+
+    return static_cast<const PGSparseArray &>((*sparse_columns)[j]).edges();
+  }
+
   SparseArray::iterator PGSparseArray::find(node_t index)
   {
-    node_t s=*start;
-    const node_t *p=start+1,*pend=start+1+2*s;
+    const uint32_t s=*start;
+    const uint32_t *p=start+1,*pend=start+1+2*s;
     for(;p<pend;p+=2) {
       if(*p==index)
         break;
@@ -223,8 +692,8 @@ namespace lsg {
  
   SparseArray::const_iterator PGSparseArray::find(node_t index) const
   {
-    node_t s=*start;
-    const node_t *p=start+1,*pend=start+1+2*s;
+    const uint32_t s=*start;
+    const uint32_t *p=start+1,*pend=start+1+2*s;
     for(;p<pend;p+=2) {
       if(*p==index)
         break;
@@ -232,4 +701,133 @@ namespace lsg {
 
     return buildConstIterator(p);
   }
+
+  template<typename Value> PGCompressedPosition<Value>
+    PGCompressedSparseArray::position(Value *v,bool atEnd) const
+  {
+    PGCompressedPosition<Value> p;
+    p.values=v;
+    p.block=block;
+    p.indices=SVBDecoder(block,n,true);
+    if(sourceFirst)
+      p.ranks=SVBDecoder(block+svbLength(block,n),n,false);
+    p.sourceFirst=sourceFirst;
+    p.firstValue=firstValue;
+    p.k=atEnd?n:0;
+    p.n=n;
+    p.load();
+
+    return p;
+  }
+
+  SparseArray::iterator PGCompressedSparseArray::begin()
+  {
+    return new PGCompressedSparseArrayIterator<value_t>(
+        position(values,false));
+  }
+
+  SparseArray::const_iterator PGCompressedSparseArray::begin() const
+  {
+    return new PGCompressedSparseArrayIterator<const value_t>(
+        position<const value_t>(values,false));
+  }
+
+  SparseArray::iterator PGCompressedSparseArray::end()
+  {
+    return new PGCompressedSparseArrayIterator<value_t>(
+        position(values,true));
+  }
+
+  SparseArray::const_iterator PGCompressedSparseArray::end() const
+  {
+    return new PGCompressedSparseArrayIterator<const value_t>(
+        position<const value_t>(values,true));
+  }
+
+  SparseArray::iterator PGCompressedSparseArray::find(node_t index)
+  {
+    PGCompressedPosition<value_t> p=position(values,false);
+    while(p.k<n && p.index<index) {
+      ++p.k;
+      p.load();
+    }
+
+    if(p.k<n && p.index!=index)
+      p.k=n;
+
+    return new PGCompressedSparseArrayIterator<value_t>(p);
+  }
+
+  SparseArray::const_iterator PGCompressedSparseArray::find(node_t index)
+    const
+  {
+    PGCompressedPosition<const value_t> p=
+      position<const value_t>(values,false);
+    while(p.k<n && p.index<index) {
+      ++p.k;
+      p.load();
+    }
+
+    if(p.k<n && p.index!=index)
+      p.k=n;
+
+    return new PGCompressedSparseArrayIterator<const value_t>(p);
+  }
+
+  void PGCompressedSparseArray::decode(vector<uint32_t> &indices,
+                                       vector<edge_t> &valueIndices) const
+  {
+    indices.resize(sourceFirst?2*n:n);
+
+    const unsigned char *next=svbDecode(block,n,true,indices.data());
+
+    if(sourceFirst) {
+      uint32_t *const ranks=indices.data()+n;
+      svbDecode(next,n,false,ranks);
+
+      valueIndices.resize(n);
+      for(uint32_t k=0;k<n;++k)
+        valueIndices[k]=sourceFirst[indices[k]]+ranks[k];
+    }
+  }
+
+  SparseArray::iterator PGSplitSparseArray::find(node_t index)
+  {
+    const EdgeSpan<value_t> e=edges();
+    EdgeSpan<value_t>::iterator it=e.begin(),itend=e.end();
+    for(;it!=itend && it.index()!=index;++it)
+      ;
+
+    return new PGSplitSparseArrayIterator<value_t>(it);
+  }
+
+  SparseArray::const_iterator PGSplitSparseArray::find(node_t index) const
+  {
+    const EdgeSpan<const value_t> e=edges();
+    EdgeSpan<const value_t>::iterator it=e.begin(),itend=e.end();
+    for(;it!=itend && it.index()!=index;++it)
+      ;
+
+    return new PGSplitSparseArrayIterator<const value_t>(it);
+  }
+
+  bool copyGraph(const string &src,const string &dst)
+  {
+    const bool toValueFile=
+      dst.size()>4 && dst.compare(dst.size()-4,4,".gpv")==0;
+
+    PackedGraphOptions options;
+    options.readOnly=true;
+    options.access=ACCESS_SEQUENTIAL;
+    const PackedGraph g(src,options);
+    if(!g.isOk())
+      return false;
+
+    if(toValueFile)
+      return g.storeValues(dst);
+    else if(g.hasValueFile())
+      return g.store(dst);
+    else
+      return copyFile(src,dst);
+  }
 }
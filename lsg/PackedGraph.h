@@ -30,18 +30,21 @@
 
 #include "Graph.h"
 #include "SparseArray.h"
+#include "StreamVByte.h"
 #include "Uncopyable.h"
 
 namespace lsg {
+  // Rows and columns of plain format files: a size followed by
+  // interleaved 32-bit (index, value index) pairs
   template<typename Value> class PGSparseArrayIterator :
     public ISparseArrayIterator<Value>, private Uncopyable {
     Value *values;
-    const node_t *it;
+    const std::uint32_t *it;
 
    public:
     virtual ~PGSparseArrayIterator() { }
     PGSparseArrayIterator(Value *v,
-                          const node_t *i) :
+                          const std::uint32_t *i) :
       values(v), it(i) {}
 
     // Methods inherited from ISparseArrayIterator
@@ -50,10 +53,6 @@ namespace lsg {
     inline virtual Value &operator*() const { return values[*(it+1)]; }
     inline virtual void operator++() { it+=2; }
     inline virtual node_t index() const { return *it; }
-    inline virtual void write(FILE *f) const
-    {
-      fwrite(it,sizeof(node_t),2,f);
-    }
     
     virtual bool operator==(const ISparseArrayIterator<Value> &sai) const
     {
@@ -72,15 +71,15 @@ namespace lsg {
   
   class PGSparseArray: public SparseArray {
     value_t * values;
-    const node_t * start;
+    const std::uint32_t * start;
 
-    inline SparseArray::iterator buildIterator(const node_t *p) const
+    inline SparseArray::iterator buildIterator(const std::uint32_t *p) const
     {
       return new PGSparseArrayIterator<value_t>(values,p);
     }
 
-    inline SparseArray::const_iterator buildConstIterator(const node_t * p)
-      const
+    inline SparseArray::const_iterator buildConstIterator(
+        const std::uint32_t *p) const
     {
       return new PGSparseArrayIterator<const value_t>(values,p);
     }
@@ -88,8 +87,8 @@ namespace lsg {
    public:
     // Constructors
     PGSparseArray() : values(0), start(0) { }
-    PGSparseArray(value_t *v,node_t *p) : values(v), start(p) { }
-    inline void set(value_t *v,node_t *p) { values=v; start=p; }
+    PGSparseArray(value_t *v,const std::uint32_t *p) : values(v), start(p) { }
+    inline void set(value_t *v,const std::uint32_t *p) { values=v; start=p; }
 
     // Destructor
     virtual ~PGSparseArray() { }
@@ -110,27 +109,268 @@ namespace lsg {
 
     inline virtual node_t size() const { return *start; }
     
-    virtual void write(FILE *f) const;
+    // Other methods
+    inline EdgeSpan<value_t> edges()
+      { return EdgeSpan<value_t>(start+1,*start,values); }
+    inline EdgeSpan<const value_t> edges() const
+      { return EdgeSpan<const value_t>(start+1,*start,values); }
+  };
+
+  template<typename Value> class PGSplitSparseArrayIterator :
+    public ISparseArrayIterator<Value>, private Uncopyable {
+    typename EdgeSpan<Value>::iterator it;
+
+   public:
+    virtual ~PGSplitSparseArrayIterator() { }
+    PGSplitSparseArrayIterator(const typename EdgeSpan<Value>::iterator &i) :
+      it(i) {}
+
+    // Methods inherited from ISparseArrayIterator
+    inline virtual ISparseArrayIterator<Value> *clone() const
+      { return new PGSplitSparseArrayIterator(it); }
+    inline virtual Value &operator*() const { return *it; }
+    inline virtual void operator++() { ++it; }
+    inline virtual node_t index() const { return it.index(); }
+
+    virtual bool operator==(const ISparseArrayIterator<Value> &sai) const
+    {
+      const PGSplitSparseArrayIterator *pgsai=
+        dynamic_cast<const PGSplitSparseArrayIterator*>(&sai);
+      if(!pgsai)
+        return 0;
+      else
+        return it==pgsai->it;
+    }
+  };
+
+  // Row or column of a CSR graph (see MAGIC_CSR): value indices of rows
+  // are positional (valueIndices is 0), those of columns are explicit
+  class PGSplitSparseArray: public SparseArray {
+    value_t *values;
+    const node_t *indices;
+    const edge_t *valueIndices;
+    node_t n;
+    edge_t firstValue;
+
+   public:
+    // Constructors
+    PGSplitSparseArray() :
+      values(0), indices(0), valueIndices(0), n(0), firstValue(0) { }
+    inline void set(value_t *v,const node_t *i,const edge_t *vi,
+                    node_t size,edge_t first)
+      { values=v; indices=i; valueIndices=vi; n=size; firstValue=first; }
+
+    // Destructor
+    virtual ~PGSplitSparseArray() { }
+
+    // Methods inherited from SparseArray
+    inline virtual SparseArray::iterator begin()
+      { return new PGSplitSparseArrayIterator<value_t>(edges().begin()); }
+    inline virtual SparseArray::const_iterator begin() const
+      { return new PGSplitSparseArrayIterator<const value_t>(
+          edges().begin()); }
+
+    inline virtual SparseArray::iterator end()
+      { return new PGSplitSparseArrayIterator<value_t>(edges().end()); }
+    inline virtual SparseArray::const_iterator end() const
+      { return new PGSplitSparseArrayIterator<const value_t>(edges().end()); }
+
+    virtual SparseArray::iterator find(node_t index);
+    virtual SparseArray::const_iterator find(node_t index) const;
+
+    inline virtual node_t size() const { return n; }
+
+    // Other methods
+    inline EdgeSpan<value_t> edges()
+      { return valueIndices?
+          EdgeSpan<value_t>(indices,1,valueIndices,1,n,values):
+          EdgeSpan<value_t>(indices,n,values,firstValue); }
+    inline EdgeSpan<const value_t> edges() const
+      { return valueIndices?
+          EdgeSpan<const value_t>(indices,1,valueIndices,1,n,values):
+          EdgeSpan<const value_t>(indices,n,values,firstValue); }
+  };
+
+  // Position in a row or a column of a compressed graph (see
+  // MAGIC_COMPRESSED); indices are decoded on the fly
+  template<typename Value> struct PGCompressedPosition {
+    Value *values;
+    const unsigned char *block;
+    SVBDecoder indices;
+    SVBDecoder ranks;           // Unused when sourceFirst is 0
+    const edge_t *sourceFirst;  // Value indices are sourceFirst[index]+rank
+    edge_t firstValue;          // ...or firstValue, firstValue+1...
+    std::uint32_t k;
+    std::uint32_t n;
+    node_t index;
+    edge_t valueIndex;
+
+    inline void load()
+    {
+      if(k<n) {
+        index=indices.next();
+        valueIndex=sourceFirst?sourceFirst[index]+ranks.next():firstValue+k;
+      }
+    }
+  };
+
+  template<typename Value> class PGCompressedSparseArrayIterator :
+    public ISparseArrayIterator<Value>, private Uncopyable {
+    PGCompressedPosition<Value> p;
+
+   public:
+    virtual ~PGCompressedSparseArrayIterator() { }
+    PGCompressedSparseArrayIterator(const PGCompressedPosition<Value> &pos) :
+      p(pos) {}
+
+    // Methods inherited from ISparseArrayIterator
+    inline virtual ISparseArrayIterator<Value> *clone() const
+      { return new PGCompressedSparseArrayIterator(p); }
+    inline virtual Value &operator*() const { return p.values[p.valueIndex]; }
+    inline virtual void operator++() { ++p.k; p.load(); }
+    inline virtual node_t index() const { return p.index; }
+
+    virtual bool operator==(const ISparseArrayIterator<Value> &sai) const
+    {
+      const PGCompressedSparseArrayIterator *pgsai=
+        dynamic_cast<const PGCompressedSparseArrayIterator*>(&sai);
+      if(!pgsai)
+        return 0;
+      else
+        return p.block==pgsai->p.block && p.k==pgsai->p.k;
+    }
+  };
+
+  class PGCompressedSparseArray: public SparseArray {
+    value_t *values;
+    const unsigned char *block;
+    std::uint32_t n;
+    edge_t firstValue;
+    const edge_t *sourceFirst;
+
+    template<typename Value>
+      PGCompressedPosition<Value> position(Value *v,bool atEnd) const;
+
+    // Decodes the indices of the array into indices, and, unless they
+    // are positional, its value indices into valueIndices
+    void decode(std::vector<std::uint32_t> &indices,
+                std::vector<edge_t> &valueIndices) const;
+
+   public:
+    // Constructors
+    PGCompressedSparseArray() :
+      values(0), block(0), n(0), firstValue(0), sourceFirst(0) { }
+    // Rows have positional value indices starting from first, columns
+    // have value indices relative to the firsts of the rows
+    inline void set(value_t *v,const unsigned char *b,std::uint32_t size,
+                    edge_t first,const edge_t *rowFirsts)
+      { values=v; block=b; n=size; firstValue=first; sourceFirst=rowFirsts; }
+
+    // Destructor
+    virtual ~PGCompressedSparseArray() { }
+
+    // Methods inherited from SparseArray
+    virtual SparseArray::iterator begin();
+    virtual SparseArray::const_iterator begin() const;
+
+    virtual SparseArray::iterator end();
+    virtual SparseArray::const_iterator end() const;
+
+    virtual SparseArray::iterator find(node_t index);
+    virtual SparseArray::const_iterator find(node_t index) const;
+
+    inline virtual node_t size() const { return n; }
+
+    // Other methods: the returned spans refer to the buffers
+    template<typename Value> EdgeSpan<Value> edges(
+        Value *v,
+        std::vector<std::uint32_t> &indices,
+        std::vector<edge_t> &valueIndices) const
+    {
+      decode(indices,valueIndices);
+
+      // Compressed graphs have 32-bit nodes
+      const node_t *i=reinterpret_cast<const node_t *>(indices.data());
+      return sourceFirst?
+        EdgeSpan<Value>(i,1,valueIndices.data(),1,n,v):
+        EdgeSpan<Value>(i,n,v,firstValue);
+    }
+    inline EdgeSpan<value_t> edges(std::vector<std::uint32_t> &indices,
+                                   std::vector<edge_t> &valueIndices)
+      { return edges(values,indices,valueIndices); }
+    inline EdgeSpan<const value_t> edges(
+        std::vector<std::uint32_t> &indices,
+        std::vector<edge_t> &valueIndices) const
+      { return edges<const value_t>(values,indices,valueIndices); }
+  };
+
+  // Expected accesses to a graph, see PackedGraph::advise
+  enum GraphAccess {
+    ACCESS_NORMAL,
+    ACCESS_SEQUENTIAL,     // rows or columns in order
+    ACCESS_RANDOM,         // rows or columns of a few nodes
+    ACCESS_WILLNEED        // the whole graph soon: read it ahead
+  };
+
+  struct PackedGraphOptions {
+    PackedGraphOptions() :
+      readOnly(false), populate(false), access(ACCESS_NORMAL),
+      lock(false), hugePages(false) {}
+
+    bool readOnly;         // open and map the file read-only, so that it
+                           // can be shared, or lie on a read-only file
+                           // system; values must then not be modified,
+                           // and transpose() is not recorded in the file
+    bool populate;         // read the whole file when opening the graph
+    GraphAccess access;
+    bool lock;             // lock the graph in memory (the graph is not
+                           // ok if this is impossible)
+    bool hugePages;        // ask for transparent huge pages, where
+                           // supported
   };
 
   class PackedGraph: public Graph {
    public:
-    PackedGraph(const std::string &filename);
+    PackedGraph(const std::string &filename,
+                const PackedGraphOptions &options=PackedGraphOptions());
     ~PackedGraph();
 
+    inline bool isReadOnly() const { return read_only; }
+    // Whether values come from a value file (see storeValues)
+    bool hasValueFile() const;
+
+    // Hint about the accesses to come, e.g., sequential for a power
+    // iteration, random for queries
+    bool advise(GraphAccess access) const;
+
+    // Stores the values of the graph as a value file (see GPV files in
+    // Graph.h), referring to the graph file this graph uses
+    bool storeValues(const std::string &filename) const;
+
     inline virtual node_t getNbNodes() const { return size; }
     inline virtual bool hasLabels() const { return with_labels; }
     inline virtual bool hasValues() const { return with_values; }
-    inline virtual node_t getNbEdges() const { return nbEdges; }
+    inline virtual edge_t getNbEdges() const { return nbEdges; }
     
-    virtual SparseArray &row(node_t i)
-      { return (*sparse_rows)[i]; }
-    virtual SparseArray &column(node_t j)
-      { return (*sparse_columns)[j]; }
-    virtual const SparseArray &row(node_t i) const
-      { return (*sparse_rows)[i]; }
-    virtual const SparseArray &column(node_t j) const
-      { return (*sparse_columns)[j]; }
+    inline bool isCompressed() const { return compressed_rows!=0; }
+
+    virtual SparseArray &row(node_t i);
+    virtual SparseArray &column(node_t j);
+    virtual const SparseArray &row(node_t i) const;
+    virtual const SparseArray &column(node_t j) const;
+
+    // For compressed graphs, rows (resp. columns) are decoded into a
+    // per-thread buffer: the span only remains valid until the next call
+    // to rowEdges (resp. columnEdges) on a compressed graph in the same
+    // thread.
+    virtual EdgeSpan<value_t> rowEdges(node_t i);
+    virtual EdgeSpan<value_t> columnEdges(node_t j);
+    virtual EdgeSpan<const value_t> rowEdges(node_t i) const;
+    virtual EdgeSpan<const value_t> columnEdges(node_t j) const;
+
+    // Read from the offsets of rows and columns, without decoding them
+    virtual node_t rowSize(node_t i) const;
+    virtual node_t columnSize(node_t j) const;
     
     virtual std::string getLabel(node_t i) const;
     virtual std::string::size_type getLabelSize(node_t i) const;
@@ -142,30 +382,67 @@ namespace lsg {
 
    private:
     node_t size;
+    edge_t nbEdges;
     bool with_labels;
     bool with_values;
+    bool with_transpose;
+    bool is_transposed;
+    bool read_only;
+
+    // Plain format
     const unsigned long *indexr;
     const unsigned long *indexc;
     const unsigned long *indexl;
-    node_t *rows;
-    node_t *columns;
+    const std::uint32_t *rows;
+    const std::uint32_t *columns;
+
+    // Extended formats
+    const edge_t *firstr;
+    const edge_t *firstc;
+    const edge_t *label_offsets;
+    const node_t *row_indices;           // CSR format
+    const node_t *column_indices;
+    const edge_t *column_value_indices;
+    const edge_t *offsetr;               // Compressed format
+    const edge_t *offsetc;
+    const unsigned char *row_stream;
+    const unsigned char *column_stream;
+
     value_t *values;
     const char *labels;
-    node_t nbEdges;
+    edge_t nbLabelBuckets;
+    const node_t *labelBuckets;
     void *mmaped_region;
     off_t filesize;
     int fd;
-    bool with_transpose;
-    bool is_transposed;
+    std::string graph_file;
+    void *value_region;                  // Value file, if any
+    off_t value_filesize;
     std::vector<PGSparseArray> *sparse_rows;
     std::vector<PGSparseArray> *sparse_columns;
+    std::vector<PGCompressedSparseArray> *compressed_rows;
+    std::vector<PGCompressedSparseArray> *compressed_columns;
+    std::vector<PGSplitSparseArray> *split_rows;
+    std::vector<PGSplitSparseArray> *split_columns;
 
+    bool map_value_file(const std::string &filename,
+                        const PackedGraphOptions &options,
+                        value_t *&file_values,std::uint64_t fields[3]);
+    bool map_plain(off_t position);
+    bool map_extended(unsigned char magic);
     void init_sparse_arrays();
     void swap_rows_columns();
 
-    virtual void writeValues(FILE *f) const;
+    inline edge_t label_offset(node_t i) const
+      { return indexl?indexl[i]:label_offsets[i]; }
+
     virtual value_t &insert_new_edge(node_t i,node_t j);
   };
+
+  // Copies the graph src (a graph or a value file) to dst: only its
+  // values if dst is a value file (ending in .gpv), the whole graph
+  // otherwise
+  bool copyGraph(const std::string &src,const std::string &dst);
 }
 
 #endif /* PACKED_GRAPH_H */
@@ -0,0 +1,374 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <queue>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "Reordering.h"
+#include "Graph.h"
+#include "GraphWriter.h"
+#include "Vector.h"
+
+using namespace std;
+
+namespace {
+  using namespace lsg;
+
+  // Numbers nodes in the given order
+  void toPermutation(const vector<node_t> &order,vector<node_t> &permutation)
+  {
+    permutation.resize(order.size());
+    for(node_t k=0;k<order.size();++k)
+      permutation[order[k]]=k;
+  }
+
+  // Inverse of permutation; returns false if it is not a permutation
+  // of its size
+  bool invert(const vector<node_t> &permutation,vector<node_t> &inverse)
+  {
+    const node_t size=permutation.size();
+    inverse.assign(size,static_cast<node_t>(-1));
+    for(node_t i=0;i<size;++i) {
+      if(permutation[i]>=size ||
+         inverse[permutation[i]]!=static_cast<node_t>(-1))
+        return false;
+      inverse[permutation[i]]=i;
+    }
+
+    return true;
+  }
+
+  void degrees(const Graph &g,vector<node_t> &degree)
+  {
+    const node_t size=g.getNbNodes();
+    degree.resize(size);
+    for(node_t i=0;i<size;++i)
+      degree[i]=g.rowSize(i)+g.columnSize(i);
+  }
+
+  // Nodes by decreasing degree, then increasing number
+  void byDecreasingDegree(const vector<node_t> &degree,vector<node_t> &order)
+  {
+    order.resize(degree.size());
+    for(node_t i=0;i<order.size();++i)
+      order[i]=i;
+    stable_sort(order.begin(),order.end(),[&](node_t a,node_t b) {
+      return degree[a]>degree[b];
+    });
+  }
+
+  void reverseCuthillMcKee(const Graph &g,vector<node_t> &order)
+  {
+    const node_t size=g.getNbNodes();
+    vector<node_t> degree;
+    degrees(g,degree);
+
+    // Each component is started from a node of smallest degree
+    vector<node_t> starts;
+    byDecreasingDegree(degree,starts);
+    reverse(starts.begin(),starts.end());
+
+    vector<bool> visited(size,false);
+    vector<node_t> neighbors;
+    order.clear();
+    order.reserve(size);
+
+    for(node_t s=0;s<size;++s) {
+      if(visited[starts[s]])
+        continue;
+
+      visited[starts[s]]=true;
+      order.push_back(starts[s]);
+
+      // order is the queue of the breadth-first search
+      for(node_t head=order.size()-1;head<order.size();++head) {
+        const node_t u=order[head];
+        neighbors.clear();
+
+        const EdgeSpan<const value_t> r=g.rowEdges(u);
+        for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+            it!=itend;++it)
+          if(!visited[it.index()]) {
+            visited[it.index()]=true;
+            neighbors.push_back(it.index());
+          }
+        const EdgeSpan<const value_t> c=g.columnEdges(u);
+        for(EdgeSpan<const value_t>::iterator it=c.begin(),itend=c.end();
+            it!=itend;++it)
+          if(!visited[it.index()]) {
+            visited[it.index()]=true;
+            neighbors.push_back(it.index());
+          }
+
+        sort(neighbors.begin(),neighbors.end(),[&](node_t a,node_t b) {
+          return degree[a]<degree[b] || (degree[a]==degree[b] && a<b);
+        });
+        order.insert(order.end(),neighbors.begin(),neighbors.end());
+      }
+    }
+
+    reverse(order.begin(),order.end());
+  }
+
+  // Greedy Gorder: the next node is the one with the largest score with
+  // the last window nodes, the score of u and v being the number of
+  // in-neighbors they share plus the number of edges between them.
+  // In-neighbors with more than sqrt(n) successors are ignored, as in
+  // the original algorithm.
+  class Gorder {
+   public:
+    Gorder(const Graph &graph,unsigned w) :
+      g(graph), size(g.getNbNodes()), window(w), keys(size,0),
+      placed(size,false),
+      hub(max<node_t>(1,static_cast<node_t>(sqrt(1.*size)))) {}
+
+    void run(vector<node_t> &order)
+    {
+      vector<node_t> degree,fallback;
+      degrees(g,degree);
+      byDecreasingDegree(degree,fallback);
+      node_t next=0;
+
+      order.clear();
+      order.reserve(size);
+
+      while(order.size()<size) {
+        node_t u=best();
+        if(u==static_cast<node_t>(-1)) {
+          // No node related to the window: the largest one left
+          while(placed[fallback[next]])
+            ++next;
+          u=fallback[next];
+        }
+
+        placed[u]=true;
+        order.push_back(u);
+        update(u,1);
+        if(order.size()>window)
+          update(order[order.size()-1-window],-1);
+
+        if(heap.size()>8*static_cast<size_t>(size))
+          rebuild();
+      }
+    }
+
+   private:
+    typedef pair<long,node_t> Entry;
+
+    // Larger keys first, then smaller nodes
+    struct Lower {
+      bool operator()(const Entry &a,const Entry &b) const
+        { return a.first<b.first || (a.first==b.first && a.second>b.second); }
+    };
+
+    const Graph &g;
+    const node_t size;
+    const unsigned window;
+    vector<long> keys;
+    vector<bool> placed;
+    const node_t hub;
+    // Entries whose key is not that of their node are outdated
+    priority_queue<Entry,vector<Entry>,Lower> heap;
+
+    node_t best()
+    {
+      while(!heap.empty()) {
+        const Entry e=heap.top();
+        if(!placed[e.second] && keys[e.second]==e.first)
+          return e.first>0?e.second:static_cast<node_t>(-1);
+        heap.pop();
+      }
+      return static_cast<node_t>(-1);
+    }
+
+    inline void add(node_t v,long delta)
+    {
+      if(placed[v])
+        return;
+      keys[v]+=delta;
+      if(keys[v]>0)
+        heap.push(Entry(keys[v],v));
+    }
+
+    // Adds delta to the scores of the nodes related to u
+    void update(node_t u,long delta)
+    {
+      const EdgeSpan<const value_t> r=g.rowEdges(u);
+      for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+          it!=itend;++it)
+        add(it.index(),delta);
+
+      const EdgeSpan<const value_t> c=g.columnEdges(u);
+      for(EdgeSpan<const value_t>::iterator it=c.begin(),itend=c.end();
+          it!=itend;++it) {
+        add(it.index(),delta);
+
+        const EdgeSpan<const value_t> siblings=g.rowEdges(it.index());
+        if(siblings.size()>hub)
+          continue;
+        for(EdgeSpan<const value_t>::iterator s=siblings.begin(),
+            send=siblings.end();s!=send;++s)
+          if(s.index()!=u)
+            add(s.index(),delta);
+      }
+    }
+
+    void rebuild()
+    {
+      heap=priority_queue<Entry,vector<Entry>,Lower>();
+      for(node_t v=0;v<size;++v)
+        if(!placed[v] && keys[v]>0)
+          heap.push(Entry(keys[v],v));
+    }
+  };
+
+  const char PERMUTATION_MAGIC[]="PRM0";
+}
+
+namespace lsg {
+  void computeOrdering(const Graph &g,NodeOrdering ordering,
+                       vector<node_t> &permutation,unsigned window)
+  {
+    vector<node_t> order;
+
+    if(ordering==ORDER_DEGREE) {
+      vector<node_t> degree;
+      degrees(g,degree);
+      byDecreasingDegree(degree,order);
+    } else if(ordering==ORDER_RCM)
+      reverseCuthillMcKee(g,order);
+    else
+      Gorder(g,max(window,1u)).run(order);
+
+    toPermutation(order,permutation);
+  }
+
+  bool storePermuted(const Graph &g,const vector<node_t> &permutation,
+                     const string &filename)
+  {
+    const node_t size=g.getNbNodes();
+    vector<node_t> inverse;
+    if(permutation.size()!=size || !invert(permutation,inverse))
+      return false;
+
+    vector<node_t> columnSizes(size);
+    for(node_t j=0;j<size;++j)
+      columnSizes[permutation[j]]=g.columnSize(j);
+
+    GraphWriter w(filename,columnSizes,g.hasLabels());
+    if(!w.isOk())
+      return false;
+
+    vector<pair<node_t,value_t> > row;
+    for(node_t k=0;k<size;++k) {
+      const EdgeSpan<const value_t> r=g.rowEdges(inverse[k]);
+      row.clear();
+      for(EdgeSpan<const value_t>::iterator it=r.begin(),itend=r.end();
+          it!=itend;++it)
+        row.push_back(make_pair(permutation[it.index()],*it));
+      sort(row.begin(),row.end());
+
+      for(vector<pair<node_t,value_t> >::const_iterator it=row.begin();
+          it!=row.end();++it)
+        w.add(k,it->first,it->second);
+    }
+
+    if(g.hasLabels())
+      for(node_t k=0;k<size;++k)
+        w.addLabel(g.getLabel(inverse[k]));
+
+    return w.close();
+  }
+
+  bool permute(const Vector &v,const vector<node_t> &permutation,
+               Vector &result)
+  {
+    vector<node_t> inverse;
+    if(permutation.size()!=v.size() || !invert(permutation,inverse))
+      return false;
+
+    Vector permuted(v.size());
+    for(node_t i=0;i<v.size();++i)
+      permuted[permutation[i]]=v[i];
+    result=permuted;
+    return true;
+  }
+
+  bool storePermutation(const vector<node_t> &permutation,
+                        const string &filename)
+  {
+    FILE *f=fopen(filename.c_str(),"wb");
+    if(!f)
+      return false;
+
+    const uint64_t size=permutation.size();
+    vector<uint64_t> entries(permutation.begin(),permutation.end());
+    bool ok=fwrite(PERMUTATION_MAGIC,1,4,f)==4 &&
+      fwrite(&size,sizeof(uint64_t),1,f)==1 &&
+      fwrite(entries.data(),sizeof(uint64_t),size,f)==size;
+
+    return !fclose(f) && ok;
+  }
+
+  bool loadPermutation(const string &filename,vector<node_t> &permutation)
+  {
+    FILE *f=fopen(filename.c_str(),"rb");
+    if(!f)
+      return false;
+
+    char magic[4];
+    uint64_t size;
+    bool ok=fread(magic,1,4,f)==4 && !strncmp(magic,PERMUTATION_MAGIC,4) &&
+      fread(&size,sizeof(uint64_t),1,f)==1 &&
+      size<=static_cast<node_t>(-1);
+
+    // The size must match the length of the file
+    if(ok) {
+      const long position=ftell(f);
+      ok=!fseek(f,0,SEEK_END) &&
+        static_cast<uint64_t>(ftell(f)-position)==size*sizeof(uint64_t) &&
+        !fseek(f,position,SEEK_SET);
+    }
+
+    vector<uint64_t> entries;
+    if(ok) {
+      entries.resize(size);
+      ok=fread(entries.data(),sizeof(uint64_t),size,f)==size;
+    }
+    fclose(f);
+
+    // Entries must be distinct nodes, checked before narrowing to node_t
+    ok=ok && all_of(entries.begin(),entries.end(),
+                    [size](uint64_t e) { return e<size; });
+    vector<node_t> loaded(entries.begin(),entries.end()),inverse;
+    if(!ok || !invert(loaded,inverse))
+      return false;
+
+    permutation.swap(loaded);
+    return true;
+  }
+}
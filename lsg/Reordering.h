@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef REORDERING_H
+#define REORDERING_H
+
+#include <string>
+#include <vector>
+
+#include "lsg.h"
+
+namespace lsg {
+  class Graph;
+  class Vector;
+
+  enum NodeOrdering {
+    ORDER_DEGREE,   // by decreasing degree (in- plus out-degree)
+    ORDER_RCM,      // reverse Cuthill-McKee, edges taken as undirected
+    ORDER_GORDER    // greedy window heuristic of Gorder (Wei et al.,
+                    // SIGMOD 2016): nodes sharing in-neighbors, or
+                    // linked, are numbered close to each other
+  };
+
+  // Numbering of the nodes of g improving the locality of products and
+  // traversals: permutation[i] is the new number of node i. window is
+  // the size of the window of ORDER_GORDER.
+  void computeOrdering(const Graph &g,NodeOrdering ordering,
+                       std::vector<node_t> &permutation,
+                       unsigned window=5);
+
+  // Stores g as a GPH file, node i becoming node permutation[i], with
+  // its label and the values of its edges. Memory usage only depends on
+  // the number of nodes and on the largest degree.
+  bool storePermuted(const Graph &g,const std::vector<node_t> &permutation,
+                     const std::string &filename);
+
+  // Renumbers the coordinates of v: result[permutation[i]]=v[i];
+  // returns false if permutation is not a permutation of the
+  // coordinates of v
+  bool permute(const Vector &v,const std::vector<node_t> &permutation,
+               Vector &result);
+
+  // Permutations are stored as "PRM0", their size and their entries,
+  // as 64-bit integers; loading fails unless the entries are a
+  // permutation of the nodes
+  bool storePermutation(const std::vector<node_t> &permutation,
+                        const std::string &filename);
+  bool loadPermutation(const std::string &filename,
+                       std::vector<node_t> &permutation);
+}
+
+#endif /* REORDERING_H */
@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+
+#include "Similarity.h"
+#include "Graph.h"
+#include "Vector.h"
+#include "Tools.h"
+
+using namespace std;
+
+namespace lsg {
+  TfIdf::TfIdf(const Graph &graph,unsigned nbThreads) :
+    g(graph), idfs(graph.getNbNodes()), norms(graph.getNbNodes())
+  {
+    const node_t size=g.getNbNodes();
+
+    if(!nbThreads)
+      nbThreads=getNbThreads();
+    if(nbThreads>size)
+      nbThreads=size?size:1;
+
+    runInParallel(nbThreads,[&](unsigned t) {
+      const node_t begin=static_cast<node_t>(
+                           static_cast<unsigned long>(size)*t/nbThreads),
+                   end=static_cast<node_t>(
+                           static_cast<unsigned long>(size)*(t+1)/nbThreads);
+      for(node_t k=begin;k<end;++k)
+        idfs[k]=log((1.*size)/g.columnSize(k));
+    });
+
+    vector<node_t> bounds;
+    balancedPartition(g,false,nbThreads,bounds);
+    runInParallel(nbThreads,[&](unsigned t) {
+      for(node_t i=bounds[t];i<bounds[t+1];++i) {
+        const EdgeSpan<const value_t> r=g.rowEdges(i);
+        double n=0.;
+        r.forEach([&](node_t j,value_t x) {
+          const double w=x*idfs[j];
+          n+=w*w;
+        });
+        norms[i]=n;
+      }
+    });
+  }
+
+  void TfIdf::cosines(node_t i,FrontierVector &result) const
+  {
+    const node_t size=g.getNbNodes();
+    if(result.size()!=size)
+      result=FrontierVector(size);
+    else
+      result.clear();
+
+    const EdgeSpan<const value_t> r=g.rowEdges(i);
+    for(EdgeSpan<const value_t>::iterator k=r.begin(),kend=r.end();
+        k!=kend;++k) {
+      const double idf=idfs[k.index()];
+      const double factor=*k*idf*idf;
+      if(!factor)
+        continue;
+
+      g.columnEdges(k.index()).forEach([&](node_t j,value_t w) {
+        result.add(j,factor*w);
+      });
+    }
+
+    const vector<node_t> &support=result.support();
+    for(vector<node_t>::const_iterator j=support.begin();
+        j!=support.end();++j)
+      result.set(*j,result[*j]/sqrt(norms[i]*norms[*j]));
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SIMILARITY_H
+#define SIMILARITY_H
+
+#include <vector>
+
+#include "lsg.h"
+
+namespace lsg {
+  class Graph;
+  class FrontierVector;
+
+  // TF-IDF weights of the rows of a graph, the weight of the edge (i,k)
+  // being g(i,k)*log(n/inDegree(k)), as used by the Cosine method. IDF
+  // weights and (squared) norms of rows are computed once, with
+  // nbThreads threads (getNbThreads() if 0); the graph must outlive this
+  // object.
+  class TfIdf {
+  public:
+    TfIdf(const Graph &g,unsigned nbThreads=0);
+
+    inline double idf(node_t k) const { return idfs[k]; }
+    // Sum of the squared weights of row i, as norm2()
+    inline double norm(node_t i) const { return norms[i]; }
+
+    // result[j]=cos2() of the weight vectors of rows i and j, for all
+    // rows j sharing a target with i, in time proportional to the
+    // number of edges from these targets: the columns of the targets of
+    // i are gone through once, the dot products being accumulated in
+    // result. Other coordinates of result are 0.
+    void cosines(node_t i,FrontierVector &result) const;
+
+  private:
+    const Graph &g;
+    std::vector<double> idfs;
+    std::vector<double> norms;
+  };
+}
+
+#endif /* SIMILARITY_H */
@@ -23,6 +23,7 @@
  */
 
 #include <numeric>
+#include <algorithm>
 #include <cmath>
 
 #include "SparseArray.h"
@@ -32,7 +33,7 @@ using namespace std;
 namespace lsg {
   value_t scal1(const SparseArray& sa1, const SparseArray& sa2)
   {
-    value_t v=0.;
+    double v=0.;
 
     SparseArray::const_iterator it1=sa1.begin(),
                                 itend1=sa1.end(),
@@ -71,8 +72,8 @@ namespace lsg {
   {
     return accumulate
       (sa.begin(),sa.end(),
-       value_t(),
-       PlusAbs<value_t>());
+       0.,
+       PlusAbs<double>());
   }
 
   value_t cos1(const SparseArray& sa1,const SparseArray& sa2)
@@ -82,7 +83,7 @@ namespace lsg {
 
   value_t scal2(const SparseArray& sa1, const SparseArray& sa2)
   {
-    value_t v=0.;
+    double v=0.;
 
     SparseArray::const_iterator it1=sa1.begin(),
                                 itend1=sa1.end(),
@@ -121,8 +122,8 @@ namespace lsg {
   {
     return accumulate
       (sa.begin(),sa.end(),
-       value_t(),
-       PlusSquare<value_t>());
+       0.,
+       PlusSquare<double>());
   }
 
   value_t cos2(const SparseArray& sa1,const SparseArray& sa2)
@@ -139,4 +140,25 @@ namespace lsg {
     else
       return *it;
   }
+
+  void bestEntries(const SparseArray &a,node_t k,
+                   vector<pair<node_t,value_t> > &best)
+  {
+    best.clear();
+    for(SparseArray::const_iterator it=a.begin(),itend=a.end();
+        it!=itend;
+        ++it)
+      best.push_back(make_pair(it.index(),*it));
+
+    auto better=[](const pair<node_t,value_t> &x,
+                   const pair<node_t,value_t> &y) {
+      return x.second>y.second || (x.second==y.second && x.first<y.first);
+    };
+
+    if(k<best.size()) {
+      nth_element(best.begin(),best.begin()+k,best.end(),better);
+      best.resize(k);
+    }
+    sort(best.begin(),best.end(),better);
+  }
 }
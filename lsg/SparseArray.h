@@ -26,6 +26,8 @@
 #define SPARSE_ARRAY_H
 
 #include <iterator>
+#include <vector>
+#include <utility>
 
 #include "lsg.h"
 
@@ -39,7 +41,6 @@ namespace lsg {
     virtual void operator++()=0;
     virtual bool operator==(const ISparseArrayIterator &it) const=0;
     virtual node_t index() const=0;
-    virtual void write(FILE *f) const=0;
   };
 
   template<typename Value> class SparseArrayIteratorTemplate :
@@ -112,10 +113,116 @@ namespace lsg {
       return !(*it==*sai.it);
     }
 
-    inline void write(FILE *f) const
+  };
+
+  // View of the indices and values of a row or a column. Indices are
+  // read with a stride (so as to skip interleaved value indices), value
+  // indices are either 64-bit, or 32-bit (plain format files, see
+  // PGSparseArray), or implicit, values being consecutive (row-ordered
+  // storage, see MAGIC_CSR). Iterators are plain values: iterating
+  // allocates nothing and involves no virtual call, but every step
+  // tests the layout of value indices; forEach tests it once, and
+  // should be preferred in inner loops. A span is invalidated by any
+  // modification of the structure of the graph it comes from.
+  template<typename Value> class EdgeSpan {
+   public:
+    class iterator {
+      const node_t *it;
+      const edge_t *wide;           // 0 unless 64-bit value indices
+      const std::uint32_t *narrow;  // 0 unless 32-bit value indices
+      Value *values;
+      edge_t pos;                   // Value index, when implicit
+      unsigned stride;
+      unsigned wideStride;
+      unsigned narrowStride;
+
+     public:
+      iterator(const node_t *i,unsigned s,
+               const edge_t *w,unsigned ws,
+               const std::uint32_t *n,unsigned ns,
+               Value *v,edge_t p) :
+        it(i), wide(w), narrow(n), values(v), pos(p),
+        stride(s), wideStride(ws), narrowStride(ns) {}
+
+      inline Value &operator*() const { return values[valueIndex()]; }
+      inline Value &value() const { return values[valueIndex()]; }
+      inline node_t index() const { return *it; }
+      inline edge_t valueIndex() const
+        { return wide?*wide:narrow?*narrow:pos; }
+
+      inline iterator &operator++()
+      {
+        it+=stride;
+        wide+=wideStride;
+        narrow+=narrowStride;
+        ++pos;
+        return *this;
+      }
+      inline bool operator==(const iterator &i) const { return it==i.it; }
+      inline bool operator!=(const iterator &i) const { return it!=i.it; }
+    };
+
+    EdgeSpan() :
+      first(0), wide(0), narrow(0), values(0), n(0), firstValue(0),
+      stride(1), wideStride(0), narrowStride(0) {}
+    // Interleaved 32-bit (index, value index) pairs
+    EdgeSpan(const std::uint32_t *f,node_t size,Value *v) :
+      first(reinterpret_cast<const node_t *>(f)), wide(0), narrow(f+1),
+      values(v), n(size), firstValue(0),
+      stride(2*sizeof(std::uint32_t)/sizeof(node_t)), wideStride(0),
+      narrowStride(2) {}
+    // Indices and 64-bit value indices, with arbitrary strides
+    EdgeSpan(const node_t *f,unsigned s,const edge_t *vi,unsigned vs,
+             node_t size,Value *v) :
+      first(f), wide(vi), narrow(0), values(v), n(size), firstValue(0),
+      stride(s), wideStride(vs), narrowStride(0) {}
+    // Indices whose value indices are fv, fv+1...
+    EdgeSpan(const node_t *f,node_t size,Value *v,edge_t fv) :
+      first(f), wide(0), narrow(0), values(v), n(size), firstValue(fv),
+      stride(1), wideStride(0), narrowStride(0) {}
+
+    inline iterator begin() const
+      { return iterator(first,stride,wide,wideStride,narrow,narrowStride,
+                        values,firstValue); }
+    inline iterator end() const
+      { return iterator(first+stride*n,stride,0,0,0,0,values,firstValue+n); }
+    inline node_t size() const { return n; }
+    inline bool empty() const { return n==0; }
+
+    // Calls f(index,value) for every entry, in order, with a loop
+    // specific to the layout of the span
+    template<typename F> inline void forEach(F f) const
     {
-      return it->write(f);
+      if(!wide && !narrow) {
+        Value *v=values+firstValue;
+        for(node_t k=0;k<n;++k)
+          f(first[k],v[k]);
+      } else if(wide && stride==1 && wideStride==1) {
+        for(node_t k=0;k<n;++k)
+          f(first[k],values[wide[k]]);
+      } else if(wide) {
+        const node_t *i=first;
+        const edge_t *w=wide;
+        for(node_t k=0;k<n;++k,i+=stride,w+=wideStride)
+          f(*i,values[*w]);
+      } else {
+        const node_t *i=first;
+        const std::uint32_t *w=narrow;
+        for(node_t k=0;k<n;++k,i+=stride,w+=narrowStride)
+          f(*i,values[*w]);
+      }
     }
+
+   private:
+    const node_t *first;
+    const edge_t *wide;
+    const std::uint32_t *narrow;
+    Value *values;
+    node_t n;
+    edge_t firstValue;
+    unsigned stride;
+    unsigned wideStride;
+    unsigned narrowStride;
   };
 
   class SparseArray {
@@ -137,8 +244,6 @@ namespace lsg {
     virtual value_t operator[](node_t index) const;
     
     virtual node_t size() const=0;
-
-    virtual void write(FILE *f) const=0;
   };
     
   value_t scal1(const SparseArray& sa1, const SparseArray& sa2);
@@ -149,6 +254,11 @@ namespace lsg {
   
   value_t cos1(const SparseArray& sa1,const SparseArray& sa2);
   value_t cos2(const SparseArray& sa1,const SparseArray& sa2);
+
+  // The (at most) k entries of a with the largest values, by decreasing
+  // value, then increasing index
+  void bestEntries(const SparseArray &a,node_t k,
+                   std::vector<std::pair<node_t,value_t> > &best);
 }
 
 #endif /* SPARSE_ARRAY_H */
@@ -0,0 +1,159 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+#include "StreamVByte.h"
+
+using namespace std;
+
+namespace {
+  inline unsigned byteLength(uint32_t v)
+  {
+    return v<(1u<<8)?1:v<(1u<<16)?2:v<(1u<<24)?3:4;
+  }
+
+  struct Tables {
+    unsigned char length[256];
+#ifdef __SSSE3__
+    unsigned char shuffle[256][16];
+#endif
+
+    Tables()
+    {
+      for(unsigned c=0;c<256;++c) {
+        unsigned l=0;
+#ifdef __SSSE3__
+        unsigned char *s=shuffle[c];
+#endif
+        for(unsigned k=0;k<4;++k) {
+          const unsigned code=(c>>(2*k))&3;
+#ifdef __SSSE3__
+          for(unsigned b=0;b<4;++b)
+            s[4*k+b]=b<=code?l+b:0x80;
+#endif
+          l+=code+1;
+        }
+        length[c]=l;
+      }
+    }
+  };
+
+  const Tables &tables()
+  {
+    static const Tables t;
+    return t;
+  }
+}
+
+namespace lsg {
+  void svbEncode(const uint32_t *in,uint32_t n,bool differential,
+                 vector<unsigned char> &out)
+  {
+    const size_t controlStart=out.size();
+    out.resize(controlStart+(n+3)/4,0);
+
+    uint32_t previous=0;
+    for(uint32_t k=0;k<n;++k) {
+      const uint32_t v=differential?in[k]-previous:in[k];
+      previous=in[k];
+
+      const unsigned l=byteLength(v);
+      out[controlStart+k/4]|=(l-1)<<(2*(k%4));
+
+      for(unsigned b=0;b<l;++b)
+        out.push_back((v>>(8*b))&0xFF);
+    }
+  }
+
+  size_t svbLength(const unsigned char *in,uint32_t n)
+  {
+    const Tables &t=tables();
+    const uint32_t nbControl=(n+3)/4;
+
+    size_t length=nbControl;
+    for(uint32_t c=0;c<n/4;++c)
+      length+=t.length[in[c]];
+
+    for(uint32_t k=n&~3u;k<n;++k)
+      length+=((in[k/4]>>(2*(k%4)))&3)+1;
+
+    return length;
+  }
+
+  const unsigned char *svbDecode(const unsigned char *in,uint32_t n,
+                                 bool differential,uint32_t *out)
+  {
+    const unsigned char *control=in;
+    const unsigned char *data=in+(n+3)/4;
+    uint32_t k=0;
+    uint32_t previous=0;
+
+#ifdef __SSSE3__
+    const Tables &t=tables();
+    __m128i prev=_mm_setzero_si128();
+
+    for(;k+4<=n;k+=4) {
+      const unsigned char c=control[k/4];
+      __m128i v=_mm_shuffle_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(t.shuffle[c])));
+      data+=t.length[c];
+
+      if(differential) {
+        v=_mm_add_epi32(v,_mm_slli_si128(v,4));
+        v=_mm_add_epi32(v,_mm_slli_si128(v,8));
+        v=_mm_add_epi32(v,prev);
+        prev=_mm_shuffle_epi32(v,0xFF);
+      }
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out+k),v);
+    }
+
+    if(k)
+      previous=out[k-1];
+#endif
+
+    static const uint32_t masks[4]={0xFFu,0xFFFFu,0xFFFFFFu,0xFFFFFFFFu};
+
+    for(;k<n;++k) {
+      const unsigned code=(control[k/4]>>(2*(k%4)))&3;
+
+      uint32_t v;
+      memcpy(&v,data,sizeof(uint32_t));
+      v&=masks[code];
+      data+=code+1;
+
+      if(differential)
+        v+=previous;
+      out[k]=previous=v;
+    }
+
+    return data;
+  }
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef STREAM_VBYTE_H
+#define STREAM_VBYTE_H
+
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+namespace lsg {
+  // Stream VByte encoding of sequences of 32-bit integers (Lemire, Kurz
+  // and Rupp, 2017): n integers are encoded as (n+3)/4 control bytes,
+  // holding 2 bits per integer (its number of bytes minus 1), followed
+  // by the significant bytes of the integers. In differential mode,
+  // the differences between consecutive integers (the first one being
+  // relative to 0) are encoded instead, which is what sorted sequences
+  // of node numbers need.
+  //
+  // Decoders may read up to SVB_PADDING bytes after the end of the
+  // encoded sequence, which must therefore be followed by that many
+  // readable bytes.
+  const size_t SVB_PADDING=16;
+
+  void svbEncode(const std::uint32_t *in,std::uint32_t n,bool differential,
+                 std::vector<unsigned char> &out);
+
+  // Decodes n integers into out, and returns the end of the encoded
+  // sequence. Uses SSSE3 when available.
+  const unsigned char *svbDecode(const unsigned char *in,std::uint32_t n,
+                                 bool differential,std::uint32_t *out);
+
+  // Number of bytes of the encoding of n integers starting at in
+  size_t svbLength(const unsigned char *in,std::uint32_t n);
+
+  // Decodes an encoded sequence one integer at a time
+  class SVBDecoder {
+    const unsigned char *control;
+    const unsigned char *data;
+    std::uint32_t k;
+    std::uint32_t current;
+    bool differential;
+
+   public:
+    SVBDecoder() : control(0), data(0), k(0), current(0),
+                   differential(false) {}
+    SVBDecoder(const unsigned char *in,std::uint32_t n,bool d) :
+      control(in), data(in+(n+3)/4), k(0), current(0), differential(d) {}
+
+    inline std::uint32_t next()
+    {
+      static const std::uint32_t masks[4]=
+        {0xFFu,0xFFFFu,0xFFFFFFu,0xFFFFFFFFu};
+      const unsigned code=(control[k>>2]>>((k&3)*2))&3;
+
+      std::uint32_t v;
+      memcpy(&v,data,sizeof(std::uint32_t));
+      v&=masks[code];
+
+      data+=code+1;
+      ++k;
+
+      current=differential?current+v:v;
+      return current;
+    }
+  };
+}
+
+#endif /* STREAM_VBYTE_H */
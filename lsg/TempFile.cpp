@@ -25,6 +25,7 @@
 #include "TempFile.h"
 
 #include <cstdlib>
+#include <vector>
 #include <unistd.h>
 
 using namespace std;
@@ -69,9 +70,14 @@ namespace {
   namespace lsg {
     TempFile::TempFile()
     {
-      char rep[]="/tmp/LSGXXXXXX";
-      mkdtemp(rep);
-      repname=rep;
+      // Temporary files may be large (see GraphBuilder): TMPDIR is
+      // honored
+      const char *dir=getenv("TMPDIR");
+      string tmplate=string(dir && *dir?dir:"/tmp")+"/LSGXXXXXX";
+      std::vector<char> rep(tmplate.begin(),tmplate.end());
+      rep.push_back('\0');
+      mkdtemp(&rep[0]);
+      repname=&rep[0];
 
       tmp_file=repname+"/tmp";
     }
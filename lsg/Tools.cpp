@@ -24,6 +24,7 @@
 
 #include <fstream>
 #include <iterator>
+#include <cstdlib>
 
 #include <unistd.h>
 
@@ -46,24 +47,118 @@ namespace lsg {
     if(!out.is_open())
       return false;
 
-    istreambuf_iterator<char> bufReader(in); 
-    ostreambuf_iterator<char> bufWriter(out); 
-    copy(bufReader,istreambuf_iterator<char>(),bufWriter);
+    if(in.peek()!=EOF)
+      out << in.rdbuf();
 
-    return true;
+    return out.good();
   }
     
   void seekTillAlign(int fd,size_t size) {
-    size_t pos=lseek(fd,0,SEEK_CUR);
+    off_t pos=lseek(fd,0,SEEK_CUR);
     pos=size-(pos%size);
-    if(pos!=size)
+    if(pos!=static_cast<off_t>(size))
       lseek(fd,pos,SEEK_CUR);
   }
 
   void seekTillAlign(FILE *f,size_t size) {
-    unsigned int pos=ftell(f);
+    off_t pos=ftello(f);
     pos=size-(pos%size);
-    if(pos!=size)
-      fseek(f,pos,SEEK_CUR);
+    if(pos!=static_cast<off_t>(size))
+      fseeko(f,pos,SEEK_CUR);
+  }
+
+  unsigned hashLabel(const char *s)
+  {
+    // 32-bit FNV-1a
+    unsigned h=2166136261u;
+
+    for(;*s;++s) {
+      h^=static_cast<unsigned char>(*s);
+      h*=16777619u;
+    }
+
+    return h;
+  }
+
+  LabelIndex::LabelIndex(node_t nbLabels)
+  {
+    edge_t nbBuckets=1;
+    while(nbBuckets<2*static_cast<edge_t>(nbLabels))
+      nbBuckets*=2;
+
+    buckets.resize(nbBuckets,static_cast<node_t>(-1));
+  }
+
+  void LabelIndex::add(const char *label,node_t i)
+  {
+    const edge_t mask=buckets.size()-1;
+
+    edge_t b=hashLabel(label)&mask;
+    while(buckets[b]!=static_cast<node_t>(-1))
+      b=(b+1)&mask;
+
+    buckets[b]=i;
+  }
+
+  void LabelIndex::write(FILE *f) const
+  {
+    const edge_t nbBuckets=buckets.size();
+
+    seekTillAlign(f,sizeof(edge_t));
+    fwrite(&nbBuckets,sizeof(edge_t),1,f);
+    fwrite(&buckets[0],sizeof(node_t),nbBuckets,f);
+  }
+
+  namespace {
+    unsigned nbThreads=0;
+    thread_local bool inParallelRegion=false;
+  }
+
+  ParallelRegion::ParallelRegion() : previous(inParallelRegion)
+  {
+    inParallelRegion=true;
+  }
+
+  ParallelRegion::~ParallelRegion()
+  {
+    inParallelRegion=previous;
+  }
+
+  void setNbThreads(unsigned n)
+  {
+    nbThreads=n;
+  }
+
+  unsigned getNbThreads()
+  {
+    if(inParallelRegion)
+      return 1;
+
+    if(nbThreads)
+      return nbThreads;
+
+    const char *env=getenv("LSG_THREADS");
+    if(env && atoi(env)>0)
+      return atoi(env);
+
+    unsigned n=thread::hardware_concurrency();
+    return n?n:1;
+  }
+
+  Barrier::Barrier(unsigned n) : nbThreads(n), waiting(0), generation(0)
+  {
+  }
+
+  void Barrier::wait()
+  {
+    unique_lock<mutex> lock(m);
+    const unsigned long current=generation;
+
+    if(++waiting==nbThreads) {
+      waiting=0;
+      ++generation;
+      cv.notify_all();
+    } else
+      cv.wait(lock,[this,current]() { return generation!=current; });
   }
 }
@@ -26,11 +26,95 @@
 #define TOOLS_H
 
 #include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+#include "lsg.h"
+#include "Uncopyable.h"
 
 namespace lsg {
   bool copyFile(const std::string &src, const std::string &dst);
   void seekTillAlign(int fd,size_t size);
   void seekTillAlign(FILE *f,size_t size);
+
+  // Hash function used by the label index of GPH files: changing it
+  // makes existing label indexes unusable
+  unsigned hashLabel(const char *s);
+
+  // Label index of GPH files: open addressing hash table (linear
+  // probing) from label hashes to node numbers, with a load factor of at
+  // most 1/2; empty buckets contain static_cast<node_t>(-1)
+  class LabelIndex {
+   public:
+    explicit LabelIndex(node_t nbLabels);
+    void add(const char *label,node_t i);
+
+    // Writes the number of buckets (as an edge_t) and the buckets
+    void write(FILE *f) const;
+
+   private:
+    std::vector<node_t> buckets;
+  };
+
+  // Number of threads used by parallel algorithms. Defaults to the
+  // LSG_THREADS environment variable, or to the number of hardware
+  // threads; setNbThreads(0) restores this default. Within a parallel
+  // region, it is 1, so that nested parallel algorithms do not
+  // oversubscribe the machine.
+  void setNbThreads(unsigned n);
+  unsigned getNbThreads();
+
+  // Marks the current thread as running in a parallel region, for its
+  // lifetime. runInParallel does it for its threads; other pools of
+  // threads should do it for theirs.
+  class ParallelRegion : private Uncopyable {
+   public:
+    ParallelRegion();
+    ~ParallelRegion();
+
+   private:
+    bool previous;
+  };
+
+  // Calls f(t) for t in [0,nbThreads), each call in its own thread (the
+  // calling thread takes t=0) within a parallel region, and waits for
+  // all of them
+  template<typename F> void runInParallel(unsigned nbThreads,F f)
+  {
+    std::vector<std::thread> threads;
+
+    for(unsigned t=1;t<nbThreads;++t)
+      threads.push_back(std::thread([&f,t]() {
+        ParallelRegion region;
+        f(t);
+      }));
+
+    {
+      ParallelRegion region;
+      f(0u);
+    }
+
+    for(unsigned t=0;t<threads.size();++t)
+      threads[t].join();
+  }
+
+  // Synchronizes the phases of the threads of runInParallel: wait
+  // returns once nbThreads threads have called it
+  class Barrier : private Uncopyable {
+   public:
+    explicit Barrier(unsigned nbThreads);
+    void wait();
+
+   private:
+    std::mutex m;
+    std::condition_variable cv;
+    unsigned nbThreads;
+    unsigned waiting;
+    unsigned long generation;
+  };
 }
 
 #endif /* TOOLS_H */
@@ -27,16 +27,275 @@
 #include <cstdio>
 #include <cassert>
 #include <cstring>
+#include <vector>
 
 #include <unistd.h>
 
 #include "Vector.h"
 #include "Graph.h"
 #include "SparseArray.h"
+#include "Tools.h"
 
 using namespace std;
 
+namespace {
+  using namespace lsg;
+
+  // The kernels below compute res=v*M, where the rows of the matrix M
+  // are the rows of g, or its columns if transposed.
+
+  // Push: each nonzero v[i] is scattered along row i of M
+  void pushRange(const Graph &g,bool transposed,const Vector &v,
+                 node_t begin,node_t end,double *res)
+  {
+    for(node_t i=begin;i<end;++i) if(v[i]) {
+      const double x=v[i];
+      (transposed?g.columnEdges(i):g.rowEdges(i)).forEach(
+        [res,x](node_t j,value_t w) { res[j]+=x*w; });
+    }
+  }
+
+  // Pull: res[j] is gathered along column j of M, i.e., along the
+  // stored transpose; every res[j] is written by a single thread
+  void pullRange(const Graph &g,bool transposed,const Vector &v,
+                 node_t begin,node_t end,double *res)
+  {
+    for(node_t j=begin;j<end;++j) {
+      double s=0.;
+      (transposed?g.rowEdges(j):g.columnEdges(j)).forEach(
+        [&v,&s](node_t i,value_t w) { s+=v[i]*w; });
+      res[j]=s;
+    }
+  }
+
+  // Propagation blocking: targets are split into segments of
+  // 2^BLOCK_SHIFT nodes, whose accumulators fit in cache. Contributions are
+  // first appended to the bins of their segments, which are written
+  // sequentially, then each segment is accumulated from its bins by a
+  // single thread. Sources are processed in rounds of about ROUND_EDGES
+  // edges, split between threads, which bounds the size of the bins; the
+  // threads are started once, and separate the phases with a barrier.
+  const unsigned BLOCK_SHIFT=16;
+  const edge_t ROUND_EDGES=edge_t(1)<<18;
+
+  struct Contribution {
+    node_t index;
+    double value;
+  };
+
+  // Splits [0,size) into ranges of about ROUND_EDGES/nbThreads edges,
+  // padded with empty ranges to a multiple of nbThreads
+  void splitByEdges(const Graph &g,bool transposed,unsigned nbThreads,
+                    vector<node_t> &bounds)
+  {
+    const node_t size=g.getNbNodes();
+
+    bounds.assign(1,0);
+    edge_t seen=0;
+    for(node_t i=0;i<size;++i) {
+      seen+=1+(transposed?g.columnSize(i):g.rowSize(i));
+      if(seen*nbThreads>=ROUND_EDGES || i+1==size) {
+        bounds.push_back(i+1);
+        seen=0;
+      }
+    }
+    while((bounds.size()-1)%nbThreads)
+      bounds.push_back(size);
+  }
+
+  void blockedProduct(const Graph &g,bool transposed,const Vector &v,
+                      double *res,unsigned nbThreads)
+  {
+    const node_t size=g.getNbNodes();
+    const node_t nbSegments=(size>>BLOCK_SHIFT)+1;
+
+    fill(res,res+size,0.);
+
+    vector<node_t> bounds;
+    splitByEdges(g,transposed,nbThreads,bounds);
+    const size_t nbRounds=(bounds.size()-1)/nbThreads;
+
+    vector<vector<vector<Contribution> > > bins(
+        nbThreads,vector<vector<Contribution> >(nbSegments));
+    Barrier barrier(nbThreads);
+
+    runInParallel(nbThreads,[&](unsigned t) {
+      vector<vector<Contribution> > &b=bins[t];
+
+      for(size_t r=0;r<nbRounds;++r) {
+        for(node_t s=0;s<nbSegments;++s)
+          b[s].clear();
+
+        const size_t part=r*nbThreads+t;
+        for(node_t i=bounds[part];i<bounds[part+1];++i) if(v[i]) {
+          const double x=v[i];
+          (transposed?g.columnEdges(i):g.rowEdges(i)).forEach(
+            [&b,x](node_t j,value_t w) {
+              const Contribution c={j,x*w};
+              b[j>>BLOCK_SHIFT].push_back(c);
+            });
+        }
+
+        barrier.wait();
+
+        for(node_t s=t;s<nbSegments;s+=nbThreads)
+          for(unsigned k=0;k<nbThreads;++k)
+            for(vector<Contribution>::const_iterator it=bins[k][s].begin(),
+                itend=bins[k][s].end();it!=itend;++it)
+              res[it->index]+=it->value;
+
+        barrier.wait();
+      }
+    });
+  }
+
+  void product(const Graph &g,bool transposed,const Vector &v,Vector &res,
+               SpMVKernel kernel,unsigned nbThreads)
+  {
+    const node_t size=g.getNbNodes();
+    assert(size==v.size());
+
+    if(&res==&v) {
+      Vector temp(size);
+      product(g,transposed,v,temp,kernel,nbThreads);
+      res=temp;
+      return;
+    }
+
+    if(!nbThreads)
+      nbThreads=getNbThreads();
+    if(nbThreads>size)
+      nbThreads=size?size:1;
+
+    if(kernel==SPMV_DEFAULT)
+      kernel=nbThreads==1?SPMV_PUSH:SPMV_PULL;
+
+    if(res.size()!=size)
+      res.resize(size);
+
+    if(kernel==SPMV_BLOCKED)
+      blockedProduct(g,transposed,v,&res[0],nbThreads);
+    else if(kernel==SPMV_PULL) {
+      vector<node_t> bounds;
+      balancedPartition(g,!transposed,nbThreads,bounds);
+
+      runInParallel(nbThreads,[&](unsigned t) {
+        pullRange(g,transposed,v,bounds[t],bounds[t+1],&res[0]);
+      });
+    } else {
+      static_cast<valarray<double> &>(res)=0.;
+
+      if(nbThreads==1) {
+        pushRange(g,transposed,v,0,size,&res[0]);
+        return;
+      }
+
+      // Every thread scatters into its own accumulator, which are then
+      // summed up by ranges of targets
+      vector<node_t> bounds;
+      balancedPartition(g,transposed,nbThreads,bounds);
+
+      vector<vector<double> > partial(nbThreads-1);
+
+      runInParallel(nbThreads,[&](unsigned t) {
+        double *out=&res[0];
+        if(t) {
+          partial[t-1].assign(size,0.);
+          out=&partial[t-1][0];
+        }
+        pushRange(g,transposed,v,bounds[t],bounds[t+1],out);
+      });
+
+      runInParallel(nbThreads,[&](unsigned t) {
+        const node_t begin=static_cast<node_t>(
+                             static_cast<unsigned long>(size)*t/nbThreads),
+                     end=static_cast<node_t>(
+                             static_cast<unsigned long>(size)*(t+1)/nbThreads);
+        for(unsigned k=0;k<partial.size();++k)
+          for(node_t j=begin;j<end;++j)
+            res[j]+=partial[k][j];
+      });
+    }
+  }
+}
+
 namespace lsg {
+  void FrontierVector::clear()
+  {
+    if(dense) {
+      static_cast<valarray<double> &>(values)=0.;
+      inSupport.assign(size(),false);
+      dense=false;
+    } else {
+      for(vector<node_t>::const_iterator it=nonzeros.begin();
+          it!=nonzeros.end();++it) {
+        values[*it]=0.;
+        inSupport[*it]=false;
+      }
+    }
+    nonzeros.clear();
+  }
+
+  void FrontierVector::frontierProduct(const Graph &g,bool transposed,
+                                       const FrontierVector &v,
+                                       FrontierVector &res,
+                                       double density,unsigned nbThreads)
+  {
+    const node_t size=g.getNbNodes();
+    assert(size==v.size());
+
+    if(&res==&v) {
+      FrontierVector temp(size);
+      frontierProduct(g,transposed,v,temp,density,nbThreads);
+      res=temp;
+      return;
+    }
+
+    bool dense=v.dense;
+    if(!dense) {
+      edge_t work=0;
+      for(vector<node_t>::const_iterator it=v.nonzeros.begin();
+          it!=v.nonzeros.end();++it)
+        work+=transposed?g.columnSize(*it):g.rowSize(*it);
+      dense=work>density*g.getNbEdges();
+    }
+
+    if(dense) {
+      product(g,transposed,v.values,res.values,SPMV_DEFAULT,nbThreads);
+      res.nonzeros.clear();
+      res.inSupport.clear();
+      res.dense=true;
+      return;
+    }
+
+    if(res.size()!=size)
+      res=FrontierVector(size);
+    else
+      res.clear();
+
+    for(vector<node_t>::const_iterator i=v.nonzeros.begin();
+        i!=v.nonzeros.end();++i) {
+      const double x=v.values[*i];
+      if(!x)
+        continue;
+
+      (transposed?g.columnEdges(*i):g.rowEdges(*i)).forEach(
+        [&res,x](node_t j,value_t w) { res.add(j,x*w); });
+    }
+  }
+
+  void multiply(const FrontierVector &v,const Graph &g,FrontierVector &res,
+                double density,unsigned nbThreads)
+  {
+    FrontierVector::frontierProduct(g,false,v,res,density,nbThreads);
+  }
+
+  void multiply(const Graph &g,const FrontierVector &v,FrontierVector &res,
+                double density,unsigned nbThreads)
+  {
+    FrontierVector::frontierProduct(g,true,v,res,density,nbThreads);
+  }
+
   ostream &operator<<(ostream &o,const Vector &v)
   {
     streamsize oldPrecision=o.precision(20);
@@ -110,20 +369,18 @@ namespace lsg {
       return;
     
     char magic[4];
-    if(fread(magic,1,4,f)!=4)
-      return;
-    if(strncmp(magic,"MSR0",4))
-      return;
-
     unsigned int s;
-    if(fread(&s,sizeof(unsigned int),1,f)!=sizeof(unsigned int))
+    if(fread(magic,1,4,f)!=4 || strncmp(magic,"MSR0",4) ||
+       fread(&s,sizeof(unsigned int),1,f)!=1) {
+      fclose(f);
       return;
+    }
 
     resize(s);
 
-    for(unsigned int i=0;i<s;++i)
-      if(fread(&(*this)[i],sizeof(double),1,f)!=sizeof(double))
-        return;
+    // A truncated file gives an empty vector
+    if(s && fread(&(*this)[0],sizeof(double),s,f)!=s)
+      resize(0);
 
     fclose(f);
   }
@@ -131,23 +388,15 @@ namespace lsg {
   bool Vector::store(const std::string &filename) const
   {
     FILE *f=fopen(filename.c_str(),"w");
-    if(ftruncate(fileno(f),0))
-      return false;
-
-    fseek(f,0,SEEK_SET);
-
     if(!f)
       return false;
-    
-    fwrite("MSR0",1,4,f);
 
     unsigned int s=size();
-    fwrite(&s,sizeof(unsigned int),1,f);
+    bool ok=fwrite("MSR0",1,4,f)==4 &&
+      fwrite(&s,sizeof(unsigned int),1,f)==1 &&
+      (!s || fwrite(&(*this)[0],sizeof(double),s,f)==s);
 
-    for(unsigned int i=0;i<s;++i)
-      fwrite(&(*this)[i],sizeof(double),1,f);
-
-    return !fclose(f);
+    return !fclose(f) && ok;
   }
 
   Vector &Vector::operator=(const Vector &v) 
@@ -160,67 +409,42 @@ namespace lsg {
     return *this;
   }
 
+  bool parseKernel(const string &name,SpMVKernel &kernel)
+  {
+    if(name=="push")
+      kernel=SPMV_PUSH;
+    else if(name=="pull")
+      kernel=SPMV_PULL;
+    else if(name=="blocked")
+      kernel=SPMV_BLOCKED;
+    else
+      return false;
+    return true;
+  }
+
+  void multiply(const RowVector &v,const Graph &g,RowVector &res,
+                SpMVKernel kernel,unsigned nbThreads)
+  {
+    product(g,false,v,res,kernel,nbThreads);
+  }
+
+  void multiply(const Graph &g,const ColumnVector &v,ColumnVector &res,
+                SpMVKernel kernel,unsigned nbThreads)
+  {
+    product(g,true,v,res,kernel,nbThreads);
+  }
+
   const RowVector operator*(const RowVector &v, const Graph &g)
   {
-    assert(g.getNbNodes()==v.size());
-    
     RowVector res(v.size());
-//    
-//    for(unsigned i=0;i<v.size();++i) {
-//      res[i]=0;
-//      
-//      for(SparseArray::const_iterator it=g.column(i).begin(),
-//        itend=g.column(i).end();
-//        it!=itend;
-//        ++it) {
-//        res[i]+=v[it.index()]* *it;
-//      }
-//    }
-
-//    for(unsigned i=0;i<v.size();++i)res[i]=0;
-//
-		for(unsigned i=0;i<v.size();i++)if(v[i]){
-
-			for(SparseArray::const_iterator it=g.row(i).begin(),
-					itend=g.row(i).end();
-					it!=itend;
-					++it){
-				res[it.index()]+=v[i]* *it;
-			}
-		}
-
+    multiply(v,g,res);
     return res;
   }
 
   const ColumnVector operator*(const Graph &g,const ColumnVector &v)
   {
-    assert(g.getNbNodes()==v.size());
-    
     ColumnVector res(v.size());
-    
-//    for(unsigned i=0;i<v.size();++i) {
-//      res[i]=0;
-//      
-//      for(SparseArray::const_iterator it=g.row(i).begin(),
-//        itend=g.row(i).end();
-//        it!=itend;
-//        ++it) {
-//        res[i]+=v[it.index()]* *it;
-//      }
-//    }
-
-//    for(unsigned i=0;i<v.size();++i)res[i]=0;
-
-		for(unsigned i=0;i<v.size();++i) if(v[i]){
-      
-      for(SparseArray::const_iterator it=g.column(i).begin(),
-        itend=g.column(i).end();
-        it!=itend;
-        ++it) {
-        res[it.index()]+=v[i]* *it;
-      }
-    }
-
+    multiply(g,v,res);
     return res;
   }
 
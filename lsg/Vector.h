@@ -26,8 +26,12 @@
 #define VECTOR_H
 
 #include <valarray>
+#include <vector>
+#include <string>
 #include <iosfwd>
 
+#include "lsg.h"
+
 namespace lsg {
   class Graph;
 
@@ -84,6 +88,107 @@ namespace lsg {
   };
     
   const ColumnVector operator*(const Graph &g,const ColumnVector &v);
+
+  // Kernels for vector-graph products. SPMV_PUSH scatters along the rows
+  // of the product's left operand and skips its null coordinates;
+  // SPMV_PULL gathers along the other direction of the graph (the
+  // transpose, as stored in GPH files), so that every coordinate of the
+  // result is written by a single thread. SPMV_BLOCKED pushes into bins
+  // of contributions, one per cache-sized segment of the result, which
+  // are then accumulated segment by segment (propagation blocking); it
+  // only reads the rows, and suits graphs whose result does not fit in
+  // cache. SPMV_DEFAULT is SPMV_PUSH with one thread, SPMV_PULL otherwise.
+  enum SpMVKernel { SPMV_DEFAULT, SPMV_PUSH, SPMV_PULL, SPMV_BLOCKED };
+
+  // Reads a kernel name (push, pull or blocked); returns false if unknown
+  bool parseKernel(const std::string &name,SpMVKernel &kernel);
+
+  // res=v*g and res=g*v, using nbThreads threads (getNbThreads() if 0),
+  // with nodes distributed among threads so that they have roughly the
+  // same number of edges to go through. The operators above use the
+  // default kernel and number of threads.
+  void multiply(const RowVector &v,const Graph &g,RowVector &res,
+                SpMVKernel kernel=SPMV_DEFAULT,unsigned nbThreads=0);
+  void multiply(const Graph &g,const ColumnVector &v,ColumnVector &res,
+                SpMVKernel kernel=SPMV_DEFAULT,unsigned nbThreads=0);
+
+  class FrontierVector;
+
+  // res=v*g and res=g*v. While v is sparse, its nonzero coordinates are
+  // pushed along their own edges only; once these are more than a
+  // fraction density of the edges of g, the dense kernels above are used
+  // instead, and res is dense from then on.
+  void multiply(const FrontierVector &v,const Graph &g,FrontierVector &res,
+                double density=.05,unsigned nbThreads=0);
+  void multiply(const Graph &g,const FrontierVector &v,FrontierVector &res,
+                double density=.05,unsigned nbThreads=0);
+
+  // Vector which keeps track of its nonzero coordinates while there are
+  // few of them (e.g., during the first steps of a walk from a single
+  // node), so that products with a graph cost what the edges reached
+  // cost. Coordinates are only written through set() and add().
+  class FrontierVector
+  {
+  public:
+    FrontierVector(node_t s=0) : values(s), inSupport(s,false), dense(false)
+      {}
+
+    inline node_t size() const { return values.size(); }
+    inline double operator[](node_t i) const { return values[i]; }
+    inline void set(node_t i,double x) { track(i); values[i]=x; }
+    inline void add(node_t i,double x) { track(i); values[i]+=x; }
+
+    // Sets all coordinates to 0, in time proportional to the support
+    // unless isDense()
+    void clear();
+
+    // Whether nonzero coordinates are no longer tracked
+    inline bool isDense() const { return dense; }
+    // Indices of the coordinates which may be nonzero, in no particular
+    // order; only meaningful unless isDense()
+    inline const std::vector<node_t> &support() const { return nonzeros; }
+    inline const Vector &getValues() const { return values; }
+
+    // f(i,(*this)[i]) for every nonzero coordinate
+    template<class F> void forEach(F f) const
+    {
+      if(dense) {
+        for(node_t i=0;i<size();++i)
+          if(values[i])
+            f(i,values[i]);
+      } else {
+        for(std::vector<node_t>::const_iterator it=nonzeros.begin();
+            it!=nonzeros.end();++it)
+          if(values[*it])
+            f(*it,values[*it]);
+      }
+    }
+
+    friend void multiply(const FrontierVector &v,const Graph &g,
+                         FrontierVector &res,double density,
+                         unsigned nbThreads);
+    friend void multiply(const Graph &g,const FrontierVector &v,
+                         FrontierVector &res,double density,
+                         unsigned nbThreads);
+
+  private:
+    inline void track(node_t i)
+    {
+      if(!dense && !inSupport[i]) {
+        inSupport[i]=true;
+        nonzeros.push_back(i);
+      }
+    }
+
+    static void frontierProduct(const Graph &g,bool transposed,
+                                const FrontierVector &v,FrontierVector &res,
+                                double density,unsigned nbThreads);
+
+    Vector values;
+    std::vector<node_t> nonzeros;
+    std::vector<bool> inSupport;
+    bool dense;
+  };
 }
 
 #endif /* VECTOR_H */
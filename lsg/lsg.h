@@ -25,9 +25,27 @@
 #ifndef LSG_H
 #define LSF_H
 
+#include <cstdint>
+
 namespace lsg {
+  // Node numbers are 32-bit unless the library is compiled with
+  // LSG_WIDE_NODES; edge counts, value indices and file offsets are
+  // always 64-bit
+#ifdef LSG_WIDE_NODES
+  typedef std::uint64_t node_t;
+#else
   typedef unsigned node_t;
+#endif
+  typedef std::uint64_t edge_t;
+
+  // Values of edges (and of sparse arrays) are doubles, unless the
+  // library is compiled with LSG_FLOAT_VALUES; vectors and sums of
+  // values are always double
+#ifdef LSG_FLOAT_VALUES
+  typedef float value_t;
+#else
   typedef double value_t;
+#endif
 }
 
 #endif /* LSG_H */
@@ -28,8 +28,10 @@
 #include <algorithm>
 #include <string>
 #include <sstream>
+#include <cstdint>
 
 #include "MutableGraph.h"
+#include "PackedGraph.h"
 #include "ConnectedComponents.h"
 #include "TempFile.h"
 
@@ -38,6 +40,25 @@ using namespace lsg;
 namespace tut {
   struct TestConnectedComponentsData { 
     static const std::string edge_list_example;
+
+    // Nodes reachable from i
+    static std::vector<bool> reachable(const Graph &g,node_t i)
+    {
+      std::vector<bool> seen(g.getNbNodes());
+      std::vector<node_t> stack(1,i);
+      seen[i]=true;
+      while(!stack.empty()) {
+        const node_t k=stack.back();
+        stack.pop_back();
+        for(SparseArray::const_iterator it=g.row(k).begin(),
+            itend=g.row(k).end();it!=itend;++it)
+          if(!seen[it.index()]) {
+            seen[it.index()]=true;
+            stack.push_back(it.index());
+          }
+      }
+      return seen;
+    }
   };
 
   const std::string TestConnectedComponentsData::edge_list_example=
@@ -113,4 +134,113 @@ namespace tut {
     ensure("!restriction(0,2)",!restriction(0,2));
     ensure("!restriction(2,1)",!restriction(2,1));
   }
+
+  // Components match mutual reachability, sequentially and in parallel
+  template<> template<>
+    void testobject::test<3>()
+  {
+    const double densities[]={.005,.01,.02,.1};
+
+    for(unsigned d=0;d<4;++d) {
+      MutableGraph g=RandomGraph(150,densities[d]);
+      const node_t size=g.getNbNodes();
+
+      std::vector<std::vector<bool> > reach(size);
+      for(node_t i=0;i<size;++i)
+        reach[i]=reachable(g,i);
+
+      std::vector<node_t> comp;
+      stronglyConnectedComponents(g,comp);
+
+      for(node_t i=0;i<size;++i)
+        for(node_t j=0;j<size;++j) {
+          ensure("same component iff mutually reachable",
+                 (comp[i]==comp[j])==(reach[i][j] && reach[j][i]));
+          if(reach[i][j])
+            ensure("topological order",comp[i]<=comp[j]);
+        }
+
+      for(unsigned t=1;t<=4;++t) {
+        std::vector<node_t> pcomp;
+        parallelStronglyConnectedComponents(g,pcomp,t);
+
+        node_t next=1;
+        for(node_t i=0;i<size;++i) {
+          for(node_t j=0;j<i;++j)
+            ensure("same partition",(pcomp[i]==pcomp[j])==(comp[i]==comp[j]));
+          if(pcomp[i]==next)
+            ++next;
+          else
+            ensure("numbered by smallest node",pcomp[i]<next);
+        }
+      }
+    }
+  }
+
+  // Weakly connected components match reachability in the symmetrized
+  // graph, with any number of threads
+  template<> template<>
+    void testobject::test<4>()
+  {
+    const double densities[]={.002,.005,.01};
+
+    for(unsigned d=0;d<3;++d) {
+      MutableGraph g=RandomGraph(400,densities[d]);
+      const node_t size=g.getNbNodes();
+
+      MutableGraph h=g;
+      h.transpose();
+      h|=g;
+
+      for(unsigned t=1;t<=4;++t) {
+        std::vector<node_t> comp;
+        weaklyConnectedComponents(g,comp,t);
+
+        node_t next=1;
+        for(node_t i=0;i<size;++i) {
+          if(comp[i]==next) {
+            ++next;
+            const std::vector<bool> reach=reachable(h,i);
+            for(node_t j=0;j<size;++j)
+              ensure("same component iff connected",
+                     (comp[j]==comp[i])==reach[j]);
+          } else
+            ensure("numbered by smallest node",comp[i]<next);
+        }
+      }
+    }
+  }
+
+  // Stored graphs, compressed or not, give the same components; a long
+  // cycle makes the depth-first search deep
+  template<> template<>
+    void testobject::test<5>()
+  {
+    MutableGraph g=RandomGraph(2000,.001);
+    for(node_t i=1000;i<2000;++i)
+      g(i,i+1<2000?i+1:1000)=1.;
+
+    std::vector<node_t> comp;
+    stronglyConnectedComponents(g,comp);
+    ensure("cycle",comp[1000]==comp[1999]);
+
+    for(unsigned k=0;k<2;++k) {
+      // Compressed graphs have 32-bit nodes
+      if(k && sizeof(node_t)!=sizeof(std::uint32_t))
+        break;
+
+      TempFile f;
+      if(k)
+        g.storeCompressed(f.name());
+      else
+        g.store(f.name());
+
+      PackedGraph h(f.name());
+      ensure("compressed",h.isCompressed()==(k==1));
+
+      std::vector<node_t> hcomp;
+      stronglyConnectedComponents(h,hcomp);
+      ensure("same components",hcomp==comp);
+    }
+  }
 }
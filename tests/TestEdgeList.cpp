@@ -0,0 +1,147 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tut/tut.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "EdgeList.h"
+#include "MutableGraph.h"
+#include "TempFile.h"
+#include "Tools.h"
+
+using namespace lsg;
+
+namespace tut {
+  struct TestEdgeListData { 
+    static void write(const TempFile &f,const std::string &s)
+    {
+      std::ofstream out(f.name().c_str(),std::ios::binary);
+      out << s;
+    }
+  };
+
+  typedef test_group<TestEdgeListData> testgroup;
+  typedef testgroup::object testobject;
+  testgroup edgelist_testgroup("EdgeList");
+
+  // Parallel parsing gives the same graph as operator>>, with any
+  // number of threads
+  template<> template<>
+    void testobject::test<1>()
+  {
+    MutableGraph g=RandomGraph(200,.05);
+    for(node_t i=0;i<g.getNbNodes();i+=3)
+      g(i,(i*7)%g.getNbNodes())=.125*i;
+
+    std::ostringstream oss;
+    oss << g;
+
+    std::string crlf;
+    for(size_t k=0;k<oss.str().size();++k) {
+      if(oss.str()[k]=='\n')
+        crlf+='\r';
+      crlf+=oss.str()[k];
+    }
+
+    const std::string texts[]={
+      oss.str(),
+      crlf,
+      "4\nno values\n0 1 2\n1 0\n\n2 1 3",
+      "4\nwith values\n0 1,1 2, 0.5\n1 0,0.25\n2 1,400 3,1e2\n3\n"};
+
+    for(unsigned k=0;k<4;++k) {
+      TempFile f;
+      write(f,texts[k]);
+
+      // operator>> does not handle CRLF line ends
+      std::istringstream iss(k==1?texts[0]:texts[k]);
+      MutableGraph ref(iss);
+
+      EdgeList edges(f.name());
+      ensure("ok",edges.isOk());
+      ensure_equals("nodes",edges.getNbNodes(),ref.getNbNodes());
+
+      for(unsigned t=1;t<=5;t+=2) {
+        setNbThreads(t);
+        ensure_equals("parallel parsing",MutableGraph(edges),ref);
+      }
+      setNbThreads(0);
+    }
+  }
+
+  // Invalid edge lists
+  template<> template<>
+    void testobject::test<2>()
+  {
+    const std::string texts[]={
+      "3\nno values\n0 1 x\n",
+      "3\nwith values\n0 1\n",
+      "3\nno values\n0 3\n"};
+
+    for(unsigned k=0;k<3;++k) {
+      TempFile f;
+      write(f,texts[k]);
+
+      EdgeList edges(f.name());
+      try {
+        MutableGraph g(edges);
+        fail("no exception");
+      } catch(std::domain_error &) {
+      }
+    }
+  }
+
+  // Label files
+  template<> template<>
+    void testobject::test<3>()
+  {
+    std::string s;
+    for(unsigned i=0;i<1000;++i) {
+      std::ostringstream oss;
+      oss << "label" << i << (i%2?"\r\n":"\n");
+      s+=i==500?"\n":oss.str();
+    }
+    s+="last";
+
+    TempFile f;
+    write(f,s);
+
+    for(unsigned t=1;t<=8;t*=2) {
+      setNbThreads(t);
+      LabelFile labels(f.name());
+      ensure("ok",labels.isOk());
+      ensure_equals("nb labels",labels.getNbLabels(),1001u);
+      ensure_equals("label 0",labels.getLabel(0),std::string("label0"));
+      ensure_equals("label 999",labels.getLabel(999),
+                    std::string("label999"));
+      ensure_equals("empty label",labels.getLabel(500),std::string(""));
+      ensure_equals("last label",labels.getLabel(1000),std::string("last"));
+    }
+    setNbThreads(0);
+  }
+}
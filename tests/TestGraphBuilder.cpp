@@ -0,0 +1,269 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tut/tut.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "GraphBuilder.h"
+#include "GraphWriter.h"
+#include "MutableGraph.h"
+#include "PackedGraph.h"
+#include "TempFile.h"
+
+using namespace lsg;
+
+namespace tut {
+  struct TestGraphBuilderData { 
+    // Adds the edges of g to b, in a scrambled order
+    static void addEdges(GraphBuilder &b,const Graph &g)
+    {
+      std::vector<GraphBuilder::Edge> edges;
+      for(node_t i=0;i<g.getNbNodes();++i)
+        for(SparseArray::const_iterator it=g.row(i).begin(),
+            itend=g.row(i).end();it!=itend;++it) {
+          GraphBuilder::Edge e;
+          e.i=i;
+          e.j=it.index();
+          e.v=*it;
+          edges.push_back(e);
+        }
+
+      for(size_t k=0;k<edges.size();++k)
+        std::swap(edges[k],edges[(k*7919)%edges.size()]);
+
+      for(size_t k=0;k<edges.size();++k)
+        b.add(edges[k].i,edges[k].j,edges[k].v);
+    }
+  };
+
+  typedef test_group<TestGraphBuilderData> testgroup;
+  typedef testgroup::object testobject;
+  testgroup graphbuilder_testgroup("GraphBuilder");
+
+  // In-memory and external builds give the same graph
+  template<> template<>
+    void testobject::test<1>()
+  {
+    MutableGraph g=RandomGraph(300,.05);
+    for(node_t i=0;i<g.getNbNodes();++i)
+      g(i,(i*13)%g.getNbNodes())=i+.5;
+
+    // Enough memory for all edges, then a few edges per run, so that
+    // runs are merged in several passes
+    const size_t memories[]={GraphBuilder::DEFAULT_MEMORY,
+                             16*sizeof(GraphBuilder::Edge)};
+
+    for(unsigned k=0;k<2;++k) {
+      TempFile f;
+      {
+        GraphBuilder b(f.name(),g.getNbNodes(),memories[k]);
+        addEdges(b,g);
+        ensure("close",b.close());
+      }
+
+      PackedGraph h(f.name());
+      ensure("ok",h.isOk());
+      ensure("no labels",!h.hasLabels());
+      ensure_equals("h==g",h,g);
+    }
+  }
+
+  // Labels, and missing ones
+  template<> template<>
+    void testobject::test<2>()
+  {
+    MutableGraph g(4);
+    g(0,1)=1.;
+    g(3,2)=2.;
+    g.setLabel(0,"zero");
+    g.setLabel(1,"one");
+
+    TempFile f;
+    GraphBuilder b(f.name(),4,sizeof(GraphBuilder::Edge));
+    addEdges(b,g);
+    b.addLabel("zero");
+    b.addLabel("one");
+    ensure("close",b.close());
+
+    PackedGraph h(f.name());
+    ensure_equals("h==g",h,g);
+    ensure_equals("label",h.getLabel(1),std::string("one"));
+    ensure_equals("missing label",h.getLabel(3),std::string(""));
+    ensure_equals("label lookup",h.getNodeWithLabel("zero"),0u);
+  }
+
+  // Duplicate edges keep their first value, in memory, within a run,
+  // across runs, and across merge passes; invalid edges
+  template<> template<>
+    void testobject::test<3>()
+  {
+    MutableGraph g=RandomGraph(300,.05);
+
+    const size_t memories[]={GraphBuilder::DEFAULT_MEMORY,
+                             4*sizeof(GraphBuilder::Edge),
+                             sizeof(GraphBuilder::Edge)};
+
+    for(unsigned k=0;k<3;++k) {
+      TempFile f;
+      {
+        GraphBuilder b(f.name(),g.getNbNodes(),memories[k]);
+        b.add(0,1,1.);
+        b.add(0,1,2.);
+        b.add(2,0,1.);
+        addEdges(b,g);
+        b.add(0,1,3.);
+        addEdges(b,g);
+        ensure("close",b.close());
+      }
+
+      MutableGraph expected(g);
+      expected(0,1)=1.;
+      if(!g(2,0))
+        expected(2,0)=1.;
+
+      PackedGraph h(f.name());
+      ensure("ok",h.isOk());
+      ensure_equals("h==g",h,expected);
+    }
+
+    // A single run has exact column sizes
+    {
+      TempFile f;
+      {
+        GraphBuilder b(f.name(),3,4*sizeof(GraphBuilder::Edge));
+        b.add(1,0,1.);
+        b.add(0,1,2.);
+        b.add(1,0,3.);
+        b.add(2,0,4.);
+        ensure("single run",b.close());
+      }
+
+      PackedGraph h(f.name());
+      ensure("single run ok",h.isOk());
+      ensure_equals("edges",h.getNbEdges(),3u);
+      ensure_equals("column",h.inDegree(0),2u);
+      ensure_equals("first",h(1,0),1.);
+    }
+
+    TempFile f;
+    GraphBuilder b(f.name(),3);
+    b.add(0,3,1.);
+    ensure("out of range",!b.isOk());
+  }
+
+  // Targets must be strictly increasing within a row
+  template<> template<>
+    void testobject::test<4>()
+  {
+    const std::vector<node_t> columnSizes={1,2,0};
+
+    TempFile f;
+    GraphWriter w(f.name(),columnSizes,false);
+    w.add(0,1,1.);
+    w.add(0,0,1.);
+    ensure("decreasing target",!w.isOk());
+
+    GraphWriter w2(f.name(),columnSizes,false);
+    w2.add(0,1,1.);
+    w2.add(0,1,1.);
+    ensure("repeated target",!w2.isOk());
+
+    GraphWriter w3(f.name(),columnSizes,false);
+    w3.add(0,1,1.);
+    w3.add(1,0,1.);
+    w3.add(1,1,1.);
+    ensure("close",w3.close());
+  }
+
+  // Graphs without transpose only have rows
+  template<> template<>
+    void testobject::test<5>()
+  {
+    MutableGraph g=RandomGraph(300,.05);
+    g.setLabel(0,"zero");
+
+    TempFile f;
+    {
+      GraphBuilder b(f.name(),g.getNbNodes(),GraphBuilder::DEFAULT_MEMORY,
+                     false);
+      addEdges(b,g);
+      b.addLabel("zero");
+      ensure("close",b.close());
+    }
+
+    PackedGraph h(f.name());
+    ensure("ok",h.isOk());
+    ensure_equals("h==g",h,g);
+    ensure_equals("row size",h.rowSize(0),g.rowSize(0));
+    ensure_equals("label lookup",h.getNodeWithLabel("zero"),0u);
+
+    bool thrown=false;
+    try {
+      h.columnEdges(0);
+    } catch(const std::domain_error &) {
+      thrown=true;
+    }
+    ensure("no columns",thrown);
+  }
+
+  // Aborted builds, and failed ones, leave no graph file
+  template<> template<>
+    void testobject::test<6>()
+  {
+    MutableGraph g=RandomGraph(300,.05);
+
+    TempFile f;
+    {
+      GraphBuilder b(f.name(),g.getNbNodes(),4*sizeof(GraphBuilder::Edge));
+      {
+        GraphBuilder::Inserter in(b,2);
+        for(node_t i=0;i<g.getNbNodes();++i)
+          in.add(i,(i+1)%g.getNbNodes(),1.);
+        b.abort();
+      }
+      ensure("aborted",!b.close());
+    }
+    ensure("no file",!std::ifstream(f.name().c_str()));
+
+    {
+      GraphBuilder b(f.name(),g.getNbNodes());
+      addEdges(b,g);
+      b.abort();
+    }
+    ensure("no file at destruction",!std::ifstream(f.name().c_str()));
+
+    {
+      GraphBuilder b(f.name(),3);
+      b.add(0,1,1.);
+      b.add(0,3,1.);
+      ensure("failed",!b.close());
+    }
+    ensure("no file on failure",!std::ifstream(f.name().c_str()));
+  }
+}
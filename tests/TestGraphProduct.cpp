@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tut/tut.h"
+
+#include <vector>
+#include <algorithm>
+
+#include "GraphProduct.h"
+#include "MutableGraph.h"
+#include "PackedGraph.h"
+#include "TempFile.h"
+
+using namespace lsg;
+
+namespace tut {
+  struct TestGraphProductData { 
+  };
+
+  typedef test_group<TestGraphProductData> testgroup;
+  typedef testgroup::object testobject;
+  testgroup graphproduct_testgroup("GraphProduct");
+
+  typedef std::vector<std::vector<value_t> > Matrix;
+
+  static Matrix dense(const Graph &g,bool transposed,bool pattern)
+  {
+    const node_t n=g.getNbNodes();
+    Matrix m(n,std::vector<value_t>(n,0.));
+    for(node_t i=0;i<n;++i)
+      for(SparseArray::const_iterator it=g.row(i).begin(),
+            itend=g.row(i).end();it!=itend;++it)
+        (transposed?m[it.index()][i]:m[i][it.index()])=pattern?1.:*it;
+    return m;
+  }
+
+  // Products, with transposes, patterns and top-k pruning, are those
+  // of the dense matrices, with any number of threads and memory budget
+  template<> template<>
+    void testobject::test<1>()
+  {
+    MutableGraph a=RandomGraph(60,.08),b=RandomGraph(60,.1);
+    for(node_t i=0;i<60;++i)
+      for(SparseArray::iterator it=a.row(i).begin(),itend=a.row(i).end();
+          it!=itend;++it)
+        *it=1.+(i*7+it.index())%4;
+    a.setLabel(3,"three");
+
+    for(unsigned c=0;c<16;++c) {
+      GraphProductOptions options;
+      options.transposeLeft=c&1;
+      options.transposeRight=c&2;
+      options.pattern=c&4;
+      options.diagonal=!(c&8);
+      options.topK=c%3?0:3;
+      options.nbThreads=1+c%4;
+      options.memory=c%2?1024:GraphBuilder::DEFAULT_MEMORY;
+
+      TempFile f;
+      ensure("storeProduct",storeProduct(a,b,f.name(),options));
+      PackedGraph p(f.name());
+      ensure("isOk",p.isOk());
+      ensure_equals("label",p.getLabel(3),"three");
+
+      const Matrix ma=dense(a,options.transposeLeft,options.pattern),
+        mb=dense(b,options.transposeRight,options.pattern);
+      for(node_t i=0;i<60;++i) {
+        std::vector<std::pair<value_t,node_t> > expected;
+        for(node_t j=0;j<60;++j) {
+          value_t v=0.;
+          for(node_t k=0;k<60;++k)
+            v+=ma[i][k]*mb[k][j];
+          if(v && (options.diagonal || i!=j))
+            expected.push_back(std::make_pair(-v,j));
+        }
+        if(options.topK && expected.size()>options.topK) {
+          std::sort(expected.begin(),expected.end());
+          expected.resize(options.topK);
+        }
+
+        ensure_equals("row size",p.rowEdges(i).size(),
+                      static_cast<node_t>(expected.size()));
+        for(unsigned e=0;e<expected.size();++e)
+          ensure_equals("value",p(i,expected[e].second),-expected[e].first);
+      }
+    }
+  }
+
+  // Compressed operands, whose spans share buffers in each direction,
+  // give the same products
+  template<> template<>
+    void testobject::test<2>()
+  {
+    if(sizeof(node_t)!=sizeof(std::uint32_t))
+      return;
+
+    MutableGraph a=RandomGraph(80,.08),b=RandomGraph(80,.1);
+    TempFile fa,fb;
+    ensure("store a",a.storeCompressed(fa.name()));
+    ensure("store b",b.storeCompressed(fb.name()));
+    PackedGraph ca(fa.name()),cb(fb.name());
+
+    for(unsigned c=0;c<4;++c) {
+      GraphProductOptions options;
+      options.transposeLeft=c&1;
+      options.transposeRight=c&2;
+      options.nbThreads=2;
+
+      TempFile f,cf,sf;
+      ensure("product",storeProduct(a,b,f.name(),options));
+      ensure("compressed product",storeProduct(ca,cb,cf.name(),options));
+      ensure("square",storeProduct(ca,ca,sf.name(),options));
+      ensure_equals("compressed",PackedGraph(cf.name()),PackedGraph(f.name()));
+
+      TempFile rf;
+      ensure("reference square",storeProduct(a,a,rf.name(),options));
+      ensure_equals("same graph",PackedGraph(sf.name()),
+                    PackedGraph(rf.name()));
+    }
+  }
+}
@@ -0,0 +1,107 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tut/tut.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+
+#include "MappedVector.h"
+#include "Vector.h"
+#include "TempFile.h"
+
+using namespace lsg;
+
+namespace tut {
+  struct TestMappedVectorData { 
+  };
+
+  typedef test_group<TestMappedVectorData> testgroup;
+  typedef testgroup::object testobject;
+  testgroup mappedvector_testgroup("MappedVector");
+
+  // Mapped vectors read the files written by Vector::store
+  template<> template<>
+    void testobject::test<1>()
+  {
+    RowVector v(1000);
+    for(unsigned i=0;i<v.size();++i)
+      v[i]=i%3?1./(i+1):0.;
+
+    TempFile f;
+    v.store(f.name());
+
+    MappedVector m(f.name());
+    ensure("isOk",m.isOk());
+    ensure_equals("size",m.size(),v.size());
+    for(unsigned i=0;i<v.size();++i)
+      ensure("values",m[i]==v[i]);
+  }
+
+  // Written vectors are read back by Vector and MappedVector
+  template<> template<>
+    void testobject::test<2>()
+  {
+    TempFile f;
+    {
+      WritableMappedVector w(f.name(),500);
+      ensure("isOk",w.isOk());
+      ensure_equals("size",w.size(),500u);
+      for(unsigned i=0;i<w.size();++i) {
+        ensure("zero",w[i]==0.);
+        w[i]=i*.5;
+      }
+      ensure("close",w.close());
+      ensure("closed",!w.isOk());
+    }
+
+    RowVector v(f.name());
+    ensure_equals("size",v.size(),500u);
+    MappedVector m(f.name());
+    ensure("isOk",m.isOk());
+    for(unsigned i=0;i<v.size();++i)
+      ensure("values",v[i]==i*.5 && m[i]==i*.5);
+  }
+
+  // Missing, foreign and truncated files are rejected
+  template<> template<>
+    void testobject::test<3>()
+  {
+    TempFile f;
+    ensure("missing",!MappedVector(f.name()).isOk());
+
+    FILE *file=fopen(f.name().c_str(),"w");
+    fputs("MSR1 not a vector",file);
+    fclose(file);
+    ensure("foreign",!MappedVector(f.name()).isOk());
+
+    RowVector v(10);
+    v.store(f.name());
+    ensure("complete",MappedVector(f.name()).isOk());
+    ensure("truncate",!truncate(f.name().c_str(),8+9*sizeof(double)));
+    ensure("truncated",!MappedVector(f.name()).isOk());
+    ensure_equals("truncated vector",RowVector(f.name()).size(),0u);
+  }
+}
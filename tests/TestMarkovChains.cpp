@@ -27,6 +27,8 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <cmath>
+#include <algorithm>
 
 #include "Vector.h"
 #include "MarkovChains.h"
@@ -34,6 +36,7 @@
 #include "PackedGraph.h"
 #include "TempFile.h"
 #include "ConnectedComponents.h"
+#include "NodeArray.h"
 
 using namespace lsg;
 
@@ -54,6 +57,15 @@ namespace tut {
   typedef testgroup::object testobject;
   testgroup markovchains_testgroup("MarkovChains");
 
+  // Values rounded to float (see LSG_FLOAT_VALUES) are only compared
+  // up to a relative error
+  inline bool near(double x,double y,double epsilon)
+  {
+    if(sizeof(value_t)==sizeof(float))
+      return std::abs(x-y)<=1e-5*std::max(1.,std::abs(y));
+    return std::abs(x-y)<epsilon;
+  }
+
   // Symmetrization
   template<> template<>
     void testobject::test<1>()
@@ -96,4 +108,189 @@ namespace tut {
     ensure("diff(scc)<1e-5",abs(sccw-v).sum()<1e-5);
     ensure("diff(h)<1e-5",abs(w-v).sum()<1e-5);
   }
+
+  // Adaptive Gauss-Seidel PageRank, and power iterations with every
+  // kernel, match power iteration
+  template<> template<>
+    void testobject::test<2>()
+  {
+    MutableGraph g=RandomGraph(300,.02);
+    node_t size=g.getNbNodes();
+    for(node_t j=0;j<size;++j) {
+      g.remove(7,j);
+      g.remove(11,j);
+    }
+    stochastifyRows(g);
+
+    const double d=.85;
+
+    RowVector ref(size);
+    for(node_t i=0;i<size;++i)
+      ref[i]=1./size;
+
+    for(unsigned k=0;k<200;++k) {
+      double danglingMass=0.;
+      for(node_t i=0;i<size;++i)
+        if(g.rowEdges(i).empty())
+          danglingMass+=ref[i];
+      
+      RowVector w=ref*g;
+      for(node_t i=0;i<size;++i)
+        ref[i]=d*(w[i]+danglingMass/size)+(1.-d)/size;
+    }
+
+    PageRankOptions options;
+    options.damping=d;
+    options.threshold=1e-10;
+
+    RowVector v;
+    PageRank(g,v,options);
+    ensure("adaptive",std::abs(v-ref).max()<1e-8);
+    ensure("sum",near(v.sum(),1.,1e-8));
+
+    options.adaptive=false;
+    RowVector v2;
+    PageRank(g,v2,options);
+    ensure("non adaptive",std::abs(v2-ref).max()<1e-8);
+
+    options.powerIterations=true;
+    const SpMVKernel kernels[]={SPMV_PUSH,SPMV_PULL,SPMV_BLOCKED};
+    for(unsigned k=0;k<3;++k) {
+      options.kernel=kernels[k];
+      RowVector v3;
+      PageRank(g,v3,options);
+      ensure("power iterations",std::abs(v3-ref).max()<1e-8);
+    }
+  }
+
+  // Personalized PageRank by forward push
+  template<> template<>
+    void testobject::test<3>()
+  {
+    MutableGraph g=RandomGraph(300,.02);
+    stochastifyRows(g);
+    const node_t size=g.getNbNodes();
+    const node_t seed=42;
+    const double d=.85;
+
+    RowVector ref(size);
+    for(unsigned k=0;k<300;++k) {
+      RowVector w=ref*g;
+      for(node_t i=0;i<size;++i)
+        ref[i]=d*w[i]+(i==seed?1.-d:0.);
+    }
+
+    NodeArray ppr;
+    ensure("pushes",PersonalizedPageRank(g,seed,ppr,1e-10,d)>0);
+
+    for(node_t i=0;i<size;++i)
+      ensure("close to power iteration",std::abs(ppr[i]-ref[i])<1e-7);
+
+    // A coarse epsilon only touches the neighborhood of the seed
+    NodeArray coarse;
+    PersonalizedPageRank(g,seed,coarse,.01,d);
+    ensure("local",coarse.size()<ppr.size());
+
+    std::vector<std::pair<node_t,value_t> > best;
+    bestEntries(ppr,5,best);
+    ensure_equals("top-k size",best.size(),5u);
+    ensure_equals("seed first",best[0].first,seed);
+    for(unsigned k=1;k<5;++k)
+      ensure("decreasing",best[k-1].second>=best[k].second);
+    for(node_t i=0;i<size;++i)
+      ensure("top-k",i==best[0].first || i==best[1].first ||
+             i==best[2].first || i==best[3].first || i==best[4].first ||
+             ppr[i]<=best[4].second);
+  }
+
+  // Invariant measure solvers on a slowly mixing birth-death chain,
+  // whose measure is known (its probabilities are exact floats)
+  template<> template<>
+    void testobject::test<4>()
+  {
+    const node_t size=200;
+    std::vector<double> forward(size),backward(size);
+    for(node_t i=0;i<size;++i) {
+      forward[i]=i+1<size?.25+.0625*(int(i%3)-1):0.;
+      backward[i]=i?.25:0.;
+    }
+
+    MutableGraph g(size);
+    {
+      MutableGraph::BatchInsertor bi(g);
+      for(node_t i=0;i<size;++i) {
+        bi.add(i,i,1.-forward[i]-backward[i]);
+        if(forward[i])
+          bi.add(i,i+1,forward[i]);
+        if(backward[i])
+          bi.add(i,i-1,backward[i]);
+      }
+    }
+
+    // Detailed balance
+    RowVector ref(size);
+    ref[0]=1.;
+    for(node_t i=1;i<size;++i)
+      ref[i]=ref[i-1]*forward[i-1]/backward[i];
+    ref/=ref.sum();
+
+    InvariantMeasureOptions options;
+    options.tolerance=1e-11;
+    options.maxIterations=2000;
+    options.restart=50;
+
+    const MeasureSolver solvers[]={SOLVER_GMRES,SOLVER_BICGSTAB};
+    for(unsigned k=0;k<2;++k) {
+      options.solver=solvers[k];
+      RowVector v;
+      const InvariantMeasureReport report=InvariantMeasure(g,v,options);
+      ensure("converged",report.converged);
+      ensure_equals("history",report.residuals.size(),report.iterations+1);
+      ensure("residual",report.residuals.back()<=options.tolerance);
+      ensure("sum",near(v.sum(),1.,1e-12));
+      for(node_t i=0;i<size;++i)
+        ensure("measure",near(v[i]/ref[i],1.,1e-6));
+    }
+
+    // Power iterations are much slower to converge
+    options.solver=SOLVER_POWER;
+    RowVector v;
+    const InvariantMeasureReport report=InvariantMeasure(g,v,options);
+    ensure("power",!report.converged);
+    ensure_equals("iterations",report.iterations,options.maxIterations);
+    ensure_equals("products",report.products,options.maxIterations+1ul);
+  }
+
+  // Extrapolated power iterations converge to the same measure
+  template<> template<>
+    void testobject::test<5>()
+  {
+    // A random graph around a cycle, so that it is strongly connected
+    const node_t size=300;
+    MutableGraph g(size);
+    {
+      MutableGraph::BatchInsertor bi(g);
+      for(node_t i=0;i<size;++i)
+        for(node_t j=0;j<size;++j)
+          if(j==(i+1)%size || rand()<.02*RAND_MAX)
+            bi.add(i,j,1.);
+    }
+    stochastifyRows(g);
+
+    // Rows of floats do not sum exactly to 1
+    InvariantMeasureOptions options;
+    options.tolerance=sizeof(value_t)==sizeof(float)?1e-6:1e-10;
+
+    RowVector ref;
+    ensure("bicgstab",InvariantMeasure(g,ref,options).converged);
+
+    const MeasureSolver solvers[]=
+      {SOLVER_POWER,SOLVER_QUADRATIC,SOLVER_AITKEN,SOLVER_GMRES};
+    for(unsigned k=0;k<4;++k) {
+      options.solver=solvers[k];
+      RowVector v;
+      ensure("converged",InvariantMeasure(g,v,options).converged);
+      ensure("measure",std::abs(v-ref).max()<100*options.tolerance*ref.max());
+    }
+  }
 }
@@ -127,4 +127,34 @@ namespace tut {
     h2(0,3)=1;
     ensure("g!=h2 (copy)",h2!=g);
   }
+
+  // Edge spans see the same edges as SparseArray iterators, and give
+  // write access to values
+  template<> template<>
+    void testobject::test<5>()
+  {
+    std::istringstream iss(edge_list_with_values_example);
+
+    MutableGraph g(iss);
+
+    EdgeSpan<value_t> r=g.rowEdges(2);
+    ensure_equals("size",r.size(),2u);
+
+    EdgeSpan<value_t>::iterator it=r.begin();
+    ensure_equals("first index",it.index(),1u);
+    ensure_equals("first value",*it,400.);
+    ++it;
+    ensure_equals("second index",it.index(),3u);
+    *it=7.;
+    ++it;
+    ensure("end",it==r.end());
+
+    ensure_equals("g(2,3)",g(2,3),7.);
+
+    const EdgeSpan<const value_t> c=
+      static_cast<const MutableGraph &>(g).columnEdges(1);
+    ensure_equals("column size",c.size(),2u);
+    ensure_equals("column first index",c.begin().index(),0u);
+    ensure("empty row",g.rowEdges(3).empty());
+  }
 }
@@ -26,6 +26,8 @@
 
 #include <string>
 #include <sstream>
+#include <set>
+#include <vector>
 
 #include "MutableGraph.h"
 #include "NodeArray.h"
@@ -88,4 +90,48 @@ namespace tut {
     ensure_equals("FB: sphere[2]",sphere[2],0);
     ensure_equals("FB: sphere[3]",sphere[3],1);
   }
+
+  // Spheres agree with a naive propagation, whatever the frontiers and
+  // traversal directions chosen for every hop
+  template<> template<>
+    void testobject::test<2>()
+  {
+    MutableGraph g=RandomGraph(200,.03);
+
+    const char *dirs[]={"FB","","F","FFB","B","BF","BFBF","FF","FBB"};
+    std::vector<std::string> directions(dirs,dirs+9);
+
+    for(node_t node=0;node<200;node+=37) {
+      std::vector<NodeArray> spheres;
+      directedSpheres(g,node,directions,spheres);
+      ensure_equals("number of spheres",spheres.size(),directions.size());
+
+      for(unsigned k=0;k<directions.size();++k) {
+        std::set<node_t> reached;
+        reached.insert(node);
+        for(unsigned l=0;l<directions[k].size();++l) {
+          std::set<node_t> next;
+          for(std::set<node_t>::const_iterator it=reached.begin();
+              it!=reached.end();++it) {
+            const SparseArray &sa=directions[k][l]=='B'?
+              g.column(*it):g.row(*it);
+            for(SparseArray::const_iterator j=sa.begin();j!=sa.end();++j)
+              next.insert(j.index());
+          }
+          reached.swap(next);
+        }
+
+        ensure_equals((directions[k]+": size").c_str(),
+                      static_cast<size_t>(spheres[k].size()),reached.size());
+        for(std::set<node_t>::const_iterator it=reached.begin();
+            it!=reached.end();++it)
+          ensure_equals((directions[k]+": value").c_str(),spheres[k][*it],1.);
+
+        NodeArray sphere;
+        directedSphere(g,node,directions[k],sphere);
+        ensure_equals((directions[k]+": directedSphere").c_str(),
+                      static_cast<size_t>(sphere.size()),reached.size());
+      }
+    }
+  }
 }
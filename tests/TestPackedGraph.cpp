@@ -27,10 +27,14 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <cstdio>
+
+#include <unistd.h>
 
 #include "MutableGraph.h"
 #include "PackedGraph.h"
 #include "TempFile.h"
+#include "Tools.h"
 
 using namespace lsg;
 
@@ -38,6 +42,26 @@ namespace tut {
   struct TestPackedGraphData { 
     static const std::string edge_list_example;
     static const std::string edge_list_with_values_example;
+
+    // Checks that the edge spans of h match the rows and columns of g
+    static void checkEdges(Graph &h,Graph &g)
+    {
+      for(node_t i=0;i<h.getNbNodes();++i) {
+        EdgeSpan<value_t> r=h.rowEdges(i);
+        SparseArray::iterator it=g.row(i).begin();
+        for(EdgeSpan<value_t>::iterator e=r.begin();e!=r.end();++e,++it)
+          ensure("row span",e.index()==it.index() && *e==*it);
+        ensure("row span end",it==g.row(i).end());
+        ensure_equals("row size",h.rowSize(i),g.row(i).size());
+
+        EdgeSpan<value_t> c=h.columnEdges(i);
+        it=g.column(i).begin();
+        for(EdgeSpan<value_t>::iterator e=c.begin();e!=c.end();++e,++it)
+          ensure("column span",e.index()==it.index() && *e==*it);
+        ensure("column span end",it==g.column(i).end());
+        ensure_equals("column size",h.columnSize(i),g.column(i).size());
+      }
+    }
   };
 
   const std::string TestPackedGraphData::edge_list_example=
@@ -200,4 +224,298 @@ namespace tut {
 
     ensure_equals("h==MutableGraph(g,vec)",h,MutableGraph(g,vec));
   }
+
+  // Label lookup through the label index
+  template<> template<>
+    void testobject::test<6>()
+  {
+    std::istringstream iss(edge_list_with_values_example);
+
+    MutableGraph g(iss);
+    g.setLabel(0,"zero");
+    g.setLabel(1,"one");
+    g.setLabel(2,"");
+    g.setLabel(3,"three");
+
+    TempFile f;
+    g.store(f.name());
+
+    {
+      PackedGraph h(f.name());
+
+      ensure_equals("zero",h.getNodeWithLabel("zero"),0u);
+      ensure_equals("one",h.getNodeWithLabel("one"),1u);
+      ensure_equals("empty label",h.getNodeWithLabel(""),2u);
+      ensure_equals("three",h.getNodeWithLabel("three"),3u);
+      ensure_equals("unknown label",h.getNodeWithLabel("two"),
+                    static_cast<node_t>(-1));
+      ensure_equals("getLabel",h.getLabel(3),std::string("three"));
+    }
+
+    std::vector<bool> vec(4,true);
+    vec[1]=false;
+
+    TempFile f2;
+    g.storeSubgraph(f2.name(),vec);
+
+    PackedGraph h(f2.name());
+
+    ensure_equals("subgraph zero",h.getNodeWithLabel("zero"),0u);
+    ensure_equals("subgraph three",h.getNodeWithLabel("three"),2u);
+    ensure_equals("subgraph one",h.getNodeWithLabel("one"),
+                  static_cast<node_t>(-1));
+  }
+
+  // Compressed storage
+  template<> template<>
+    void testobject::test<7>()
+  {
+    if(sizeof(node_t)!=sizeof(std::uint32_t))
+      return;
+
+    MutableGraph g=RandomGraph(300,.05);
+    for(node_t i=0;i<g.getNbNodes();++i) {
+      std::ostringstream oss;
+      oss << "node" << i;
+      g.setLabel(i,oss.str());
+    }
+    g(3,299)=1e9;
+
+    TempFile f;
+    g.storeCompressed(f.name());
+
+    PackedGraph h(f.name());
+
+    ensure("ok",h.isOk());
+    ensure("compressed",h.isCompressed());
+    ensure_equals("h==g",h,g);
+    ensure_equals("h(3,299)",h(3,299),1e9);
+    ensure_equals("label",h.getLabel(42),std::string("node42"));
+    ensure_equals("label lookup",h.getNodeWithLabel("node42"),42u);
+
+    checkEdges(h,g);
+
+    h(3,299)=2.;
+    ensure_equals("write through rows",h(3,299),2.);
+    g(3,299)=2.;
+
+    h.transpose();
+    g.transpose();
+    ensure_equals("transposed",h,g);
+    checkEdges(h,g);
+
+    TempFile f2;
+    h.store(f2.name());
+    PackedGraph h2(f2.name());
+    ensure("not compressed",!h2.isCompressed());
+    ensure_equals("h2==g",h2,g);
+  }
+
+  // CSR storage
+  template<> template<>
+    void testobject::test<8>()
+  {
+    MutableGraph g=RandomGraph(100,.1);
+    g.setLabel(7,"seven");
+
+    TempFile f;
+    g.store(f.name());
+
+    PackedGraph h(f.name());
+
+    ensure("ok",h.isOk());
+    ensure_equals("h==g",h,g);
+    ensure_equals("label lookup",h.getNodeWithLabel("seven"),7u);
+    checkEdges(h,g);
+
+    node_t i=0;
+    while(g.row(i).size()==0)
+      ++i;
+    const node_t j=g.row(i).begin().index();
+    h(i,j)=3.;
+    ensure_equals("write through rows",h(i,j),3.);
+    ensure_equals("read through columns",h.column(j)[i],3.);
+    g(i,j)=3.;
+
+    h.transpose();
+    g.transpose();
+    ensure_equals("transposed",h,g);
+    checkEdges(h,g);
+
+    TempFile f2;
+    h.store(f2.name());
+    ensure_equals("h2==g",PackedGraph(f2.name()),g);
+
+    if(sizeof(node_t)==sizeof(std::uint32_t)) {
+      TempFile f3;
+      h.storeCompressed(f3.name());
+      ensure_equals("h3==g",PackedGraph(f3.name()),g);
+    }
+  }
+
+  // Files in the plain format (32-bit interleaved pairs) remain readable
+  template<> template<>
+    void testobject::test<9>()
+  {
+    // Plain format files have 32-bit nodes and double values
+    if(sizeof(node_t)!=sizeof(std::uint32_t) ||
+       sizeof(value_t)!=sizeof(double))
+      return;
+
+    // 0 -> 1 (2.), 1 -> 0 (3.), 1 -> 1 (4.), labelled "a" and "bc"
+    TempFile f;
+    FILE *out=fopen(f.name().c_str(),"wb");
+    const char magic[4]={'G','P','H',
+      MAGIC_WITH_VALUES|MAGIC_WITH_TRANSPOSE|MAGIC_WITH_LABELS};
+    fwrite(magic,1,4,out);
+    const std::uint32_t header[2]={2,3};
+    fwrite(header,sizeof(std::uint32_t),2,out);
+    const unsigned long indexes[6]={0,3,0,3,0,2};
+    fwrite(indexes,sizeof(unsigned long),6,out);
+    const std::uint32_t rows[]={1,1,0, 2,0,1,1,2};
+    fwrite(rows,sizeof(std::uint32_t),8,out);
+    const std::uint32_t columns[]={1,1,1, 2,0,0,1,2};
+    fwrite(columns,sizeof(std::uint32_t),8,out);
+    seekTillAlign(out,sizeof(value_t));
+    const value_t values[3]={2.,3.,4.};
+    fwrite(values,sizeof(value_t),3,out);
+    fwrite("a\0bc",1,5,out);
+    fclose(out);
+
+    PackedGraph h(f.name());
+    ensure("ok",h.isOk());
+    ensure_equals("nodes",h.getNbNodes(),2u);
+    ensure_equals("edges",h.getNbEdges(),3u);
+    ensure_equals("(0,1)",h(0,1),2.);
+    ensure_equals("(1,0)",h.column(0)[1],3.);
+    ensure_equals("(1,1)",h(1,1),4.);
+    ensure_equals("label",h.getLabel(1),std::string("bc"));
+
+    MutableGraph g(h);
+    checkEdges(h,g);
+    TempFile f2;
+    h.store(f2.name());
+    ensure_equals("converted",PackedGraph(f2.name()),g);
+  }
+
+  // Graph files record the type of their values, and are only opened by
+  // a library compiled with the same type
+  template<> template<>
+    void testobject::test<10>()
+  {
+    MutableGraph g=RandomGraph(50,.1);
+    TempFile f;
+    for(unsigned compressed=0;compressed<2;++compressed) {
+      // Compressed graphs have 32-bit nodes
+      if(compressed && sizeof(node_t)!=sizeof(std::uint32_t))
+        break;
+
+      ensure("store",compressed?g.storeCompressed(f.name()):
+             g.store(f.name()));
+      ensure("same type",PackedGraph(f.name()).isOk());
+
+      FILE *file=fopen(f.name().c_str(),"r+b");
+      std::uint64_t flags;
+      ensure("read",fseek(file,8,SEEK_SET)==0 &&
+             fread(&flags,sizeof(flags),1,file)==1);
+      ensure_equals("flag",(flags&EXTENDED_FLOAT_VALUES)!=0,
+                    sizeof(value_t)==sizeof(float));
+      flags^=EXTENDED_FLOAT_VALUES;
+      fseek(file,8,SEEK_SET);
+      fwrite(&flags,sizeof(flags),1,file);
+      fclose(file);
+
+      ensure("other type",!PackedGraph(f.name()).isOk());
+    }
+  }
+
+  // Read-only graphs and mapping options give the same graph, and
+  // transposing a read-only graph leaves its file untouched
+  template<> template<>
+    void testobject::test<11>()
+  {
+    MutableGraph g=RandomGraph(80,.1);
+    TempFile f;
+    g.store(f.name());
+
+    PackedGraphOptions options;
+    options.readOnly=true;
+    for(unsigned k=0;k<4;++k) {
+      options.populate=k&1;
+      options.hugePages=k&2;
+      options.lock=k==3;
+      options.access=static_cast<GraphAccess>(k);
+
+      PackedGraph h(f.name(),options);
+      ensure("ok",h.isOk());
+      ensure("read-only",h.isReadOnly());
+      ensure_equals("graph",h,g);
+      checkEdges(h,g);
+      ensure("advise",h.advise(ACCESS_RANDOM));
+    }
+
+    {
+      PackedGraph h(f.name(),options);
+      h.transpose();
+      MutableGraph t(g);
+      t.transpose();
+      ensure_equals("transposed",h,t);
+    }
+    ensure_equals("file untouched",PackedGraph(f.name()),g);
+
+    {
+      PackedGraph h(f.name());
+      ensure("read-write",!h.isReadOnly());
+      h.transpose();
+    }
+    ensure("transposition recorded",PackedGraph(f.name())!=g);
+  }
+
+  // Value files share the structure of a graph file, whose file is left
+  // untouched by modifications and transpositions of their graphs
+  template<> template<>
+    void testobject::test<12>()
+  {
+    MutableGraph g=RandomGraph(60,.1);
+    TempFile f,other;
+    g.store(f.name());
+    const std::string near=f.name()+".gpv",far=other.name()+".gpv";
+
+    ensure("copy",copyGraph(f.name(),near));
+    {
+      PackedGraph h(near);
+      ensure("ok",h.isOk());
+      ensure("value file",h.hasValueFile());
+      ensure_equals("values",h,g);
+      h*=2.;
+      ensure("store",h.storeValues(far));
+    }
+
+    MutableGraph doubled(g);
+    doubled*=2.;
+    ensure_equals("modified",PackedGraph(near),doubled);
+    ensure_equals("other directory",PackedGraph(far),doubled);
+    ensure_equals("graph untouched",PackedGraph(f.name()),g);
+
+    {
+      PackedGraph h(far);
+      h.transpose();
+    }
+    MutableGraph t(doubled);
+    t.transpose();
+    ensure_equals("transposition recorded",PackedGraph(far),t);
+    ensure_equals("in the value file only",PackedGraph(near),doubled);
+
+    TempFile copy;
+    ensure("full copy",copyGraph(far,copy.name()));
+    PackedGraph c(copy.name());
+    ensure("graph file",c.isOk() && !c.hasValueFile());
+    ensure_equals("copied",c,t);
+
+    ensure("truncate",!truncate(near.c_str(),100));
+    ensure("truncated",!PackedGraph(near).isOk());
+
+    unlink(near.c_str());
+    unlink(far.c_str());
+  }
 }
@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tut/tut.h"
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#include "Reordering.h"
+#include "MutableGraph.h"
+#include "PackedGraph.h"
+#include "Vector.h"
+#include "TempFile.h"
+
+using namespace lsg;
+
+namespace tut {
+  struct TestReorderingData { 
+  };
+
+  typedef test_group<TestReorderingData> testgroup;
+  typedef testgroup::object testobject;
+  testgroup reordering_testgroup("Reordering");
+
+  // Largest |i-j| over the edges (i,j) of g, once renumbered
+  static node_t bandwidth(const Graph &g,const std::vector<node_t> &p)
+  {
+    node_t b=0;
+    for(node_t i=0;i<g.getNbNodes();++i)
+      for(SparseArray::const_iterator it=g.row(i).begin(),
+          itend=g.row(i).end();it!=itend;++it)
+        b=std::max(b,p[i]>p[it.index()]?p[i]-p[it.index()]:
+                   p[it.index()]-p[i]);
+    return b;
+  }
+
+  // All orderings are permutations, and the stored graphs are the
+  // renumbered graphs, with their labels
+  template<> template<>
+    void testobject::test<1>()
+  {
+    MutableGraph g=RandomGraph(200,.03);
+    for(node_t i=0;i<g.getNbNodes();++i) {
+      std::ostringstream label;
+      label << "node" << i;
+      g.setLabel(i,label.str());
+      for(SparseArray::iterator it=g.row(i).begin(),itend=g.row(i).end();
+          it!=itend;++it)
+        *it=1.+(i+it.index())%7;
+    }
+
+    const NodeOrdering orderings[]={ORDER_DEGREE,ORDER_RCM,ORDER_GORDER};
+    for(unsigned o=0;o<3;++o) {
+      std::vector<node_t> p;
+      computeOrdering(g,orderings[o],p);
+      ensure_equals("size",p.size(),static_cast<size_t>(g.getNbNodes()));
+      std::vector<node_t> sorted(p);
+      std::sort(sorted.begin(),sorted.end());
+      for(node_t k=0;k<sorted.size();++k)
+        ensure_equals("permutation",sorted[k],k);
+
+      TempFile f;
+      ensure("store",storePermuted(g,p,f.name()));
+      PackedGraph h(f.name());
+      ensure("ok",h.isOk());
+      ensure_equals("edges",h.getNbEdges(),g.getNbEdges());
+      for(node_t i=0;i<g.getNbNodes();++i) {
+        ensure_equals("label",h.getLabel(p[i]),g.getLabel(i));
+        for(SparseArray::iterator it=g.row(i).begin(),
+            itend=g.row(i).end();it!=itend;++it)
+          ensure_equals("value",h(p[i],p[it.index()]),*it);
+      }
+    }
+
+    std::vector<node_t> p(g.getNbNodes(),0);
+    TempFile f;
+    ensure("not a permutation",!storePermuted(g,p,f.name()));
+  }
+
+  // Reverse Cuthill-McKee recovers a small bandwidth from a shuffled
+  // path-like graph
+  template<> template<>
+    void testobject::test<2>()
+  {
+    const node_t size=300;
+    std::vector<node_t> shuffle(size);
+    for(node_t i=0;i<size;++i)
+      shuffle[i]=(i*127)%size;
+
+    MutableGraph g(size);
+    for(node_t i=0;i+1<size;++i) {
+      g(shuffle[i],shuffle[i+1])=1.;
+      if(i+2<size)
+        g(shuffle[i+2],shuffle[i])=1.;
+    }
+
+    std::vector<node_t> identity(size),p;
+    for(node_t i=0;i<size;++i)
+      identity[i]=i;
+    computeOrdering(g,ORDER_RCM,p);
+    ensure("rcm",bandwidth(g,p)<=2);
+    ensure("shuffled",bandwidth(g,identity)>2);
+
+    computeOrdering(g,ORDER_GORDER,p);
+    ensure("gorder",bandwidth(g,p)<bandwidth(g,identity));
+  }
+
+  // Permutations are stored and loaded back, and renumber vectors
+  template<> template<>
+    void testobject::test<3>()
+  {
+    MutableGraph g=RandomGraph(100,.05);
+    std::vector<node_t> p,q;
+    computeOrdering(g,ORDER_GORDER,p);
+
+    TempFile f;
+    ensure("store",storePermutation(p,f.name()));
+    ensure("load",loadPermutation(f.name(),q));
+    ensure("same",p==q);
+
+    RowVector v(100),w;
+    for(node_t i=0;i<100;++i)
+      v[i]=i;
+    ensure("permute",permute(v,p,w));
+    for(node_t i=0;i<100;++i)
+      ensure_equals("permuted",w[p[i]],v[i]);
+
+    ensure("not a permutation file",!loadPermutation("/nonexistent",q));
+
+    // Out-of-range and repeated entries
+    std::vector<node_t> r(p);
+    r[3]=100;
+    ensure("out of range",!permute(v,r,w));
+    ensure("store out of range",storePermutation(r,f.name()));
+    ensure("load out of range",!loadPermutation(f.name(),q));
+    r[3]=r[4];
+    ensure("repeated",!permute(v,r,w));
+    ensure("store repeated",storePermutation(r,f.name()));
+    ensure("load repeated",!loadPermutation(f.name(),q));
+    ensure("wrong size",!permute(RowVector(99),p,w));
+  }
+}
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tut/tut.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "Similarity.h"
+#include "Vector.h"
+#include "NodeArray.h"
+#include "MutableGraph.h"
+
+using namespace lsg;
+
+namespace tut {
+  struct TestSimilarityData { 
+  };
+
+  typedef test_group<TestSimilarityData> testgroup;
+  typedef testgroup::object testobject;
+  testgroup similarity_testgroup("Similarity");
+
+  // Values rounded to float (see LSG_FLOAT_VALUES) are only compared
+  // up to a relative error
+  inline bool near(double x,double y,double epsilon)
+  {
+    if(sizeof(value_t)==sizeof(float))
+      return std::abs(x-y)<=1e-5*std::max(1.,std::abs(y));
+    return std::abs(x-y)<epsilon;
+  }
+
+  static void tfidf(const Graph &g,node_t i,NodeArray &a)
+  {
+    a.clear();
+    for(SparseArray::const_iterator j=g.row(i).begin(),jend=g.row(i).end();
+        j!=jend;++j)
+      a.insert(j.index(),
+               j.value()*log((1.*g.getNbNodes())/g.inDegree(j.index())));
+  }
+
+  // One-vs-many cosines are the pairwise cos2 of TF-IDF vectors, on the
+  // FB sphere, and 0 elsewhere
+  template<> template<>
+    void testobject::test<1>()
+  {
+    MutableGraph g=RandomGraph(150,.04);
+    for(node_t i=0;i<g.getNbNodes();++i)
+      for(SparseArray::iterator it=g.row(i).begin(),itend=g.row(i).end();
+          it!=itend;++it)
+        *it=1.+(i+it.index())%5;
+
+    for(unsigned t=1;t<=3;++t) {
+      TfIdf weights(g,t);
+
+      for(node_t i=0;i<g.getNbNodes();i+=13) {
+        FrontierVector cosines;
+        weights.cosines(i,cosines);
+        ensure_equals("size",cosines.size(),g.getNbNodes());
+
+        NodeArray sphere,a,b;
+        directedSphere(g,i,"FB",sphere);
+        tfidf(g,i,a);
+        ensure("norm",near(weights.norm(i),norm2(a),1e-9));
+
+        for(node_t j=0;j<g.getNbNodes();++j) {
+          if(sphere[j]) {
+            tfidf(g,j,b);
+            ensure("cosine",near(cosines[j],cos2(a,b),1e-12));
+          } else
+            ensure_equals("outside the sphere",cosines[j],0.);
+        }
+      }
+    }
+  }
+}
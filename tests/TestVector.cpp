@@ -0,0 +1,257 @@
+/*
+ *  Copyright (c) 2006 Yann Ollivier <yann.ollivier@normalesup.org>
+ *                     Pierre Senellart <pierre@senellart.com>
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to permit
+ *  persons to whom the Software is furnished to do so, subject to the
+ *  following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN
+ *  NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ *  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ *  OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ *  USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "tut/tut.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "Vector.h"
+#include "MutableGraph.h"
+#include "PackedGraph.h"
+#include "TempFile.h"
+#include "Tools.h"
+
+using namespace lsg;
+
+namespace tut {
+  struct TestVectorData { 
+  };
+
+  typedef test_group<TestVectorData> testgroup;
+  typedef testgroup::object testobject;
+  testgroup vector_testgroup("Vector");
+
+  // All kernels and numbers of threads give the same products
+  template<> template<>
+    void testobject::test<1>()
+  {
+    MutableGraph mg=RandomGraph(200,.05);
+    TempFile f;
+    mg.store(f.name());
+    PackedGraph g(f.name());
+
+    const node_t size=g.getNbNodes();
+    RowVector v(size);
+    ColumnVector w(size);
+    for(node_t i=0;i<size;++i) {
+      v[i]=(i%7)?1./(i+1):0.;
+      w[i]=i%3;
+    }
+
+    RowVector ref;
+    ColumnVector cref;
+    multiply(v,g,ref,SPMV_PUSH,1);
+    multiply(g,w,cref,SPMV_PUSH,1);
+
+    const SpMVKernel kernels[]={SPMV_PUSH,SPMV_PULL,SPMV_BLOCKED,SPMV_DEFAULT};
+    for(unsigned k=0;k<4;++k)
+      for(unsigned t=1;t<=4;++t) {
+        RowVector res;
+        multiply(v,g,res,kernels[k],t);
+        ensure("v*g",std::abs(res-ref).max()<1e-12);
+
+        ColumnVector cres;
+        multiply(g,w,cres,kernels[k],t);
+        ensure("g*w",std::abs(cres-cref).max()<1e-12);
+      }
+
+    // In-place product
+    RowVector u=v;
+    multiply(u,g,u,SPMV_PULL,3);
+    ensure("in place",std::abs(u-ref).max()<1e-12);
+
+    ensure("operator*",std::abs(v*mg-ref).max()<1e-12);
+  }
+
+  // Walks from one node give the same vectors as dense products,
+  // whether or not the frontier switches to the dense kernels
+  template<> template<>
+    void testobject::test<2>()
+  {
+    MutableGraph mg=RandomGraph(300,.01);
+    TempFile f;
+    mg.store(f.name());
+    PackedGraph g(f.name());
+
+    const node_t size=g.getNbNodes();
+    // Walks go forward (v) and backward (w) from start
+    node_t start=0;
+    for(node_t i=0;i<size;++i)
+      if(std::min(g.outDegree(i),g.inDegree(i))>
+         std::min(g.outDegree(start),g.inDegree(start)))
+        start=i;
+
+    const double densities[]={0.,.05,1.};
+    for(unsigned d=0;d<3;++d) {
+      RowVector v(size);
+      ColumnVector w(size);
+      v[start]=1.;
+      w[start]=2.;
+
+      FrontierVector fv(size),fw(size);
+      fv.set(start,1.);
+      fw.set(start,2.);
+
+      for(unsigned step=0;step<6;++step) {
+        v=v*g;
+        w=g*w;
+        multiply(fv,g,fv,densities[d]);
+        FrontierVector next;
+        multiply(g,fw,next,densities[d],2);
+        fw=next;
+
+        for(node_t i=0;i<size;++i) {
+          ensure("v*g",std::abs(fv[i]-v[i])<1e-12);
+          ensure("g*w",std::abs(fw[i]-w[i])<1e-12);
+        }
+
+        node_t nonzeros=0;
+        fv.forEach([&](node_t i,double x) {
+          ensure("forEach",x==fv[i] && x!=0.);
+          ++nonzeros;
+        });
+        ensure_equals("support",nonzeros,
+                      static_cast<node_t>(size-std::count(&v[0],&v[0]+size,
+                                                          0.)));
+      }
+
+      if(d==0)
+        ensure("dense",fv.isDense() && fw.isDense());
+      if(d==2)
+        ensure("sparse",!fv.isDense() && !fw.isDense());
+
+      fv.clear();
+      for(node_t i=0;i<size;++i)
+        ensure("clear",fv[i]==0.);
+      ensure("clear sparse",!fv.isDense() && fv.support().empty());
+    }
+  }
+
+  // Vectors are stored and loaded back
+  template<> template<>
+    void testobject::test<3>()
+  {
+    RowVector v(100);
+    for(unsigned i=0;i<v.size();++i)
+      v[i]=1./(i+1);
+
+    TempFile f;
+    ensure("store",v.store(f.name()));
+    RowVector w(f.name());
+    ensure_equals("size",w.size(),v.size());
+    ensure("values",std::abs(w-v).max()==0.);
+
+    ensure("empty store",RowVector().store(f.name()));
+    ensure_equals("empty",RowVector(f.name()).size(),0u);
+  }
+
+  // Blocked products over several segments of the result and several
+  // rounds of sources
+  template<> template<>
+    void testobject::test<4>()
+  {
+    const node_t size=300000;
+    MutableGraph mg(size);
+    {
+      MutableGraph::BatchInsertor bi(mg);
+      for(node_t i=0;i<size;++i)
+        for(node_t k=1;k<=(i%29);++k)
+          bi.add(i,static_cast<node_t>((i*7919ul+k*104729ul)%size),1./k);
+    }
+    TempFile f;
+    mg.store(f.name());
+    PackedGraph g(f.name());
+
+    RowVector v(size);
+    ColumnVector w(size);
+    for(node_t i=0;i<size;++i) {
+      v[i]=(i%5)?1./(i+1):0.;
+      w[i]=i%3;
+    }
+
+    RowVector ref,res;
+    ColumnVector cref,cres;
+    multiply(v,g,ref,SPMV_PUSH,1);
+    multiply(g,w,cref,SPMV_PUSH,1);
+
+    for(unsigned t=1;t<=4;t+=3) {
+      multiply(v,g,res,SPMV_BLOCKED,t);
+      ensure("v*g",std::abs(res-ref).max()<1e-12);
+      multiply(g,w,cres,SPMV_BLOCKED,t);
+      ensure("g*w",std::abs(cres-cref).max()<1e-10);
+    }
+  }
+
+  // Nested parallel products are single-threaded, barriers, and
+  // partitions are cached until the graph is transposed
+  template<> template<>
+    void testobject::test<5>()
+  {
+    setNbThreads(3);
+    ensure_equals("threads",getNbThreads(),3u);
+
+    std::vector<unsigned> nested(3);
+    runInParallel(3,[&](unsigned t) { nested[t]=getNbThreads(); });
+    for(unsigned t=0;t<3;++t)
+      ensure_equals("nested",nested[t],1u);
+    ensure_equals("after",getNbThreads(),3u);
+
+    // Every thread sees the writes of all threads of the previous phase
+    Barrier barrier(3);
+    std::vector<unsigned> phases(3),mismatches(3);
+    runInParallel(3,[&](unsigned t) {
+      for(unsigned p=1;p<=50;++p) {
+        phases[t]=p;
+        barrier.wait();
+        if(phases[0]+phases[1]+phases[2]!=3*p)
+          ++mismatches[t];
+        barrier.wait();
+      }
+    });
+    for(unsigned t=0;t<3;++t)
+      ensure_equals("barrier",mismatches[t],0u);
+
+    MutableGraph g(100);
+    {
+      MutableGraph::BatchInsertor bi(g);
+      for(node_t j=0;j<100;++j)
+        bi.add(0,j,1.);
+      for(node_t i=1;i<100;++i)
+        bi.add(i,i,1.);
+    }
+
+    std::vector<node_t> rows,columns,cached;
+    balancedPartition(g,false,3,rows);
+    balancedPartition(g,true,3,columns);
+    ensure("different",rows!=columns);
+    balancedPartition(g,false,3,cached);
+    ensure("cached",cached==rows);
+
+    g.transpose();
+    balancedPartition(g,false,3,cached);
+    ensure("transposed",cached==columns);
+    setNbThreads(0);
+  }
+}